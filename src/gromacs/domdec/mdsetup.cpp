@@ -72,7 +72,8 @@ void mdAlgorithmsSetupAtomData(const t_commrec*     cr,
                                MDAtoms*             mdAtoms,
                                Constraints*         constr,
                                VirtualSitesHandler* vsite,
-                               gmx_shellfc_t*       shellfc)
+                               gmx_shellfc_t*       shellfc,
+                               fda::FDASettings*    fdaSettings)
 {
     bool usingDomDec = DOMAINDECOMP(cr);
 
@@ -108,7 +109,7 @@ void mdAlgorithmsSetupAtomData(const t_commrec*     cr,
     }
     else
     {
-        gmx_mtop_generate_local_top(top_global, top, ir->efep != efepNO);
+        gmx_mtop_generate_local_top(top_global, top, ir->efep != efepNO, fdaSettings);
     }
 
     if (vsite)
@@ -54,6 +54,11 @@ struct t_forcerec;
 struct t_inputrec;
 struct t_mdatoms;
 
+namespace fda
+{
+struct FDASettings;
+}
+
 namespace gmx
 {
 class Constraints;
@@ -86,6 +91,7 @@ void make_local_shells(const t_commrec* cr, const t_mdatoms* md, gmx_shellfc_t*
  * \param[in,out] constr     The constraints handler, can be NULL
  * \param[in,out] vsite      The virtual site data, can be NULL
  * \param[in,out] shellfc    The shell/flexible-constraint data, can be NULL
+ * \param[in]     fdaSettings Filters the bonded interactions of a serial run for FDA, can be NULL
  */
 void mdAlgorithmsSetupAtomData(const t_commrec*     cr,
                                const t_inputrec*    ir,
@@ -96,7 +102,8 @@ void mdAlgorithmsSetupAtomData(const t_commrec*     cr,
                                MDAtoms*             mdAtoms,
                                Constraints*         constr,
                                VirtualSitesHandler* vsite,
-                               gmx_shellfc_t*       shellfc);
+                               gmx_shellfc_t*       shellfc,
+                               fda::FDASettings*    fdaSettings = nullptr);
 
 } // namespace gmx
 
@@ -0,0 +1,73 @@
+/*
+ * ActiveRows.h
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_ACTIVEROWS_H_
+#define SRC_GROMACS_FDA_ACTIVEROWS_H_
+
+#include <algorithm>
+#include <vector>
+
+namespace fda {
+
+/**
+ * Set of the rows of DistributedForces which have entries in the current frame
+ *
+ * With small FDA groups only a few of the syslen rows are used, so that clearing
+ * and writing only the active rows is much cheaper than walking over all rows.
+ * The rows are returned in ascending order to keep the output order unchanged.
+ * Insertion is not thread-safe.
+ */
+class ActiveRows
+{
+public:
+
+    ActiveRows(int syslen)
+     : is_active(syslen, false)
+    {}
+
+    void insert(int i)
+    {
+        if (is_active[i]) return;
+        is_active[i] = true;
+        if (sorted and !rows.empty() and rows.back() > i) sorted = false;
+        rows.push_back(i);
+    }
+
+    /// Active rows in ascending order
+    std::vector<int> const& get() const
+    {
+        if (!sorted) {
+            std::sort(rows.begin(), rows.end());
+            sorted = true;
+        }
+        return rows;
+    }
+
+    size_t size() const { return rows.size(); }
+
+    void clear()
+    {
+        for (int i : rows) is_active[i] = false;
+        rows.clear();
+        sorted = true;
+    }
+
+private:
+
+    /// Flag per row
+    std::vector<bool> is_active;
+
+    /// Active rows, sorted on demand
+    mutable std::vector<int> rows;
+
+    mutable bool sorted = true;
+
+};
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_ACTIVEROWS_H_ */
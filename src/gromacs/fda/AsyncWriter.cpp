@@ -0,0 +1,68 @@
+/*
+ * AsyncWriter.cpp
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include "AsyncWriter.h"
+#include "gromacs/utility/exceptions.h"
+
+namespace fda {
+
+AsyncWriter::AsyncWriter()
+ : pending(0),
+   stop(false),
+   thread(&AsyncWriter::run, this)
+{}
+
+AsyncWriter::~AsyncWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    task_added.notify_one();
+    thread.join();
+}
+
+void AsyncWriter::push(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+        ++pending;
+    }
+    task_added.notify_one();
+}
+
+void AsyncWriter::wait(size_t max_pending)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    task_finished.wait(lock, [&]{ return pending <= max_pending; });
+}
+
+void AsyncWriter::run()
+{
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            task_added.wait(lock, [&]{ return stop or !tasks.empty(); });
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        try {
+            task();
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --pending;
+        }
+        task_finished.notify_all();
+    }
+}
+
+} // namespace fda
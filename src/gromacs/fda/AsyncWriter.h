@@ -0,0 +1,67 @@
+/*
+ * AsyncWriter.h
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_ASYNCWRITER_H_
+#define SRC_GROMACS_FDA_ASYNCWRITER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace fda {
+
+/**
+ * Background thread executing write tasks in the order of submission
+ *
+ * Used to overlap the formatting and writing of a frame with the force
+ * computation of the next frame. The caller bounds the memory by waiting
+ * until the number of pending tasks drops below the number of its frame buffers.
+ */
+class AsyncWriter
+{
+public:
+
+    AsyncWriter();
+
+    /// Finishes all pending tasks
+    ~AsyncWriter();
+
+    AsyncWriter(AsyncWriter const&) = delete;
+    AsyncWriter& operator = (AsyncWriter const&) = delete;
+
+    void push(std::function<void()> task);
+
+    /// Block until at most max_pending tasks are queued or running
+    void wait(size_t max_pending = 0);
+
+private:
+
+    void run();
+
+    std::deque<std::function<void()>> tasks;
+
+    /// Number of tasks queued or running
+    size_t pending;
+
+    bool stop;
+
+    std::mutex mutex;
+
+    std::condition_variable task_added;
+
+    std::condition_variable task_finished;
+
+    /// Must be the last member to be started after the initialization of the others
+    std::thread thread;
+
+};
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_ASYNCWRITER_H_ */
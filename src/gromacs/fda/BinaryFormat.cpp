@@ -0,0 +1,134 @@
+/*
+ * BinaryFormat.cpp
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <cstring>
+#include "BinaryFormat.h"
+#include "gromacs/utility/fatalerror.h"
+
+namespace fda {
+
+namespace {
+
+const char header_magic[4] = {'F', 'D', 'A', 'B'};
+const char index_magic[4] = {'F', 'D', 'A', 'X'};
+
+void write_string(std::ostream& os, std::string const& s)
+{
+    uint32_t length = s.size();
+    os.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    os.write(s.data(), length);
+}
+
+std::string read_string(std::istream& is)
+{
+    uint32_t length = 0;
+    is.read(reinterpret_cast<char*>(&length), sizeof(length));
+    std::string s(length, ' ');
+    is.read(&s[0], length);
+    return s;
+}
+
+} // namespace
+
+bool is_binary_format(std::istream& is)
+{
+    char magic[4] = {};
+    auto pos = is.tellg();
+    is.read(magic, sizeof(magic));
+    bool result = is and std::memcmp(magic, header_magic, sizeof(magic)) == 0;
+    is.clear();
+    is.seekg(pos);
+    return result;
+}
+
+void write_binary_header(std::ostream& os, BinaryHeader const& header)
+{
+    auto begin = os.tellp();
+    os.write(header_magic, sizeof(header_magic));
+    os.write(reinterpret_cast<const char*>(&header.version), sizeof(header.version));
+    os.write(reinterpret_cast<const char*>(&header.syslen), sizeof(header.syslen));
+    os.write(reinterpret_cast<const char*>(&header.real_size), sizeof(header.real_size));
+    os.write(reinterpret_cast<const char*>(&header.result_type), sizeof(header.result_type));
+    os.write(reinterpret_cast<const char*>(&header.force_size), sizeof(header.force_size));
+    os.write(reinterpret_cast<const char*>(&header.entry_size), sizeof(header.entry_size));
+    write_string(os, header.group1);
+    write_string(os, header.group2);
+
+    // Align the frames to 8 bytes
+    const char zeros[8] = {};
+    os.write(zeros, (8 - (os.tellp() - begin) % 8) % 8);
+}
+
+BinaryHeader read_binary_header(std::istream& is)
+{
+    BinaryHeader header;
+    auto begin = is.tellg();
+    char magic[4];
+    is.read(magic, sizeof(magic));
+    if (!is or std::memcmp(magic, header_magic, sizeof(magic)) != 0) gmx_fatal(FARGS, "Wrong file type, FDA binary header expected.");
+    is.read(reinterpret_cast<char*>(&header.version), sizeof(header.version));
+    if (header.version != BinaryHeader::current_version) gmx_fatal(FARGS, "Unsupported FDA binary version %u.", header.version);
+    is.read(reinterpret_cast<char*>(&header.syslen), sizeof(header.syslen));
+    is.read(reinterpret_cast<char*>(&header.real_size), sizeof(header.real_size));
+    if (header.real_size != sizeof(real)) gmx_fatal(FARGS, "FDA binary file was written with a real size of %u bytes, but %zu is used.", header.real_size, sizeof(real));
+    is.read(reinterpret_cast<char*>(&header.result_type), sizeof(header.result_type));
+    is.read(reinterpret_cast<char*>(&header.force_size), sizeof(header.force_size));
+    is.read(reinterpret_cast<char*>(&header.entry_size), sizeof(header.entry_size));
+    header.group1 = read_string(is);
+    header.group2 = read_string(is);
+    if (!is) gmx_fatal(FARGS, "Error reading FDA binary header.");
+
+    header.size = is.tellg() - begin;
+    header.size += (8 - header.size % 8) % 8;
+    is.seekg(begin + static_cast<std::streamoff>(header.size));
+    return header;
+}
+
+void write_binary_index(std::ostream& os, std::vector<uint64_t> const& frame_offsets)
+{
+    uint64_t nb_frames = frame_offsets.size();
+    os.write(reinterpret_cast<const char*>(frame_offsets.data()), nb_frames * sizeof(uint64_t));
+    os.write(reinterpret_cast<const char*>(&nb_frames), sizeof(nb_frames));
+    os.write(index_magic, sizeof(index_magic));
+}
+
+std::vector<uint64_t> read_binary_frame_offsets(std::istream& is, BinaryHeader const& header)
+{
+    is.seekg(0, is.end);
+    uint64_t length = is.tellg();
+    const uint64_t trailer_size = sizeof(uint64_t) + sizeof(index_magic);
+
+    std::vector<uint64_t> frame_offsets;
+    if (length >= header.size + trailer_size) {
+        uint64_t nb_frames = 0;
+        char magic[4];
+        is.seekg(length - trailer_size);
+        is.read(reinterpret_cast<char*>(&nb_frames), sizeof(nb_frames));
+        is.read(magic, sizeof(magic));
+        if (std::memcmp(magic, index_magic, sizeof(magic)) == 0 and nb_frames * sizeof(uint64_t) <= length - header.size - trailer_size) {
+            frame_offsets.resize(nb_frames);
+            is.seekg(length - trailer_size - nb_frames * sizeof(uint64_t));
+            is.read(reinterpret_cast<char*>(frame_offsets.data()), nb_frames * sizeof(uint64_t));
+            return frame_offsets;
+        }
+    }
+
+    // No trailer, skip through the complete frames
+    for (uint64_t offset = header.size; offset + sizeof(uint64_t) <= length;) {
+        uint64_t nb_entries = 0;
+        is.seekg(offset);
+        is.read(reinterpret_cast<char*>(&nb_entries), sizeof(nb_entries));
+        uint64_t end = offset + sizeof(nb_entries) + nb_entries * header.entry_size;
+        if (end > length) break;
+        frame_offsets.push_back(offset);
+        offset = end;
+    }
+    is.clear();
+    return frame_offsets;
+}
+
+} // namespace fda
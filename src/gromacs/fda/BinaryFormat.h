@@ -0,0 +1,102 @@
+/*
+ * BinaryFormat.h
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_BINARYFORMAT_H_
+#define SRC_GROMACS_FDA_BINARYFORMAT_H_
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "gromacs/utility/real.h"
+
+namespace fda {
+
+/**
+ * Seekable binary format of the pairwise forces, version 2
+ *
+ * Header:  magic "FDAB", version, syslen, real size, result type, number of force components,
+ *          entry size and the names of group 1 and 2, padded to a multiple of 8 bytes
+ * Frame:   uint64 number of entries followed by the entries as BinaryEntry
+ * Trailer: uint64 file offsets of all frames, uint64 number of frames and magic "FDAX"
+ *
+ * The trailer is written when the run finishes, files without trailer (e.g. of an aborted run)
+ * are indexed by skipping through the frames.
+ */
+struct BinaryHeader
+{
+    static constexpr uint32_t current_version = 2;
+
+    uint32_t version = current_version;
+
+    /// Number of atoms/residues, 0 if unknown
+    uint32_t syslen = 0;
+
+    uint32_t real_size = sizeof(real);
+
+    /// ResultType as integer
+    int32_t result_type = 0;
+
+    /// 1 for scalar and 3 for vector forces
+    uint32_t force_size = 1;
+
+    /// Size of a BinaryEntry in bytes
+    uint32_t entry_size = 0;
+
+    std::string group1;
+    std::string group2;
+
+    /// Size of the header in the file, set by read_binary_header
+    uint64_t size = 0;
+};
+
+/// Pairwise force entry with N force components, written and read as a whole
+template <int N>
+struct BinaryEntry
+{
+    int32_t i;
+    int32_t j;
+    real force[N];
+    int32_t type;
+};
+
+/// Returns true if the stream starts with the magic of the binary format, the stream position is not changed
+bool is_binary_format(std::istream& is);
+
+void write_binary_header(std::ostream& os, BinaryHeader const& header);
+
+BinaryHeader read_binary_header(std::istream& is);
+
+/// Write a frame of entries with N force components
+template <int N>
+void write_binary_frame(std::ostream& os, std::vector<BinaryEntry<N>> const& entries)
+{
+    uint64_t nb_entries = entries.size();
+    os.write(reinterpret_cast<const char*>(&nb_entries), sizeof(nb_entries));
+    os.write(reinterpret_cast<const char*>(entries.data()), nb_entries * sizeof(BinaryEntry<N>));
+}
+
+/// Read a frame of entries with N force components at the current stream position
+template <int N>
+std::vector<BinaryEntry<N>> read_binary_frame(std::istream& is)
+{
+    uint64_t nb_entries = 0;
+    is.read(reinterpret_cast<char*>(&nb_entries), sizeof(nb_entries));
+    std::vector<BinaryEntry<N>> entries(nb_entries);
+    is.read(reinterpret_cast<char*>(entries.data()), nb_entries * sizeof(BinaryEntry<N>));
+    return entries;
+}
+
+/// Write the trailer with the frame offsets
+void write_binary_index(std::ostream& os, std::vector<uint64_t> const& frame_offsets);
+
+/// Returns the file offsets of all frames, read from the trailer or by skipping through the frames
+std::vector<uint64_t> read_binary_frame_offsets(std::istream& is, BinaryHeader const& header);
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_BINARYFORMAT_H_ */
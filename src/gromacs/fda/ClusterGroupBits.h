@@ -0,0 +1,73 @@
+/*
+ * ClusterGroupBits.h
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_CLUSTERGROUPBITS_H_
+#define SRC_GROMACS_FDA_CLUSTERGROUPBITS_H_
+
+#include <vector>
+#include "FDASettings.h"
+
+namespace fda {
+
+/**
+ * FDA group membership of the nbnxm clusters
+ *
+ * Bit 0 is set if a cluster contains a group1 atom and bit 1 if it contains a group2 atom.
+ * The bits are precomputed once per nonbonded kernel call, so that the kernels can skip
+ * all FDA work of a cluster pair with a single branch.
+ */
+class ClusterGroupBits
+{
+public:
+
+    /// Number of nbnxm atoms per entry, the size of the CPU i-clusters
+    static constexpr int cluster_size = 4;
+
+    /// cellInv maps the natoms nbnxm atoms to the global atom index, filler atoms are negative
+    void update(FDASettings const& fda_settings, int const* cellInv, int natoms)
+    {
+        bits.assign((natoms + cluster_size - 1) / cluster_size, 0);
+        for (int a = 0; a != natoms; ++a) {
+            int atom = cellInv[a];
+            if (atom < 0) continue;
+            bits[a / cluster_size] |= (fda_settings.sys_in_group1[atom] ? 1 : 0) | (fda_settings.sys_in_group2[atom] ? 2 : 0);
+        }
+    }
+
+    /// Set all bits to zero, no cluster pair will be processed
+    void clear(int natoms)
+    {
+        bits.assign((natoms + cluster_size - 1) / cluster_size, 0);
+    }
+
+    /// Group bits of the i-cluster ci
+    int i_cluster(int ci) const { return bits[ci]; }
+
+    /// Group bits of the j-cluster cj with j_cluster_size atoms, conservative for j-clusters smaller than cluster_size
+    int j_cluster(int cj, int j_cluster_size) const
+    {
+        int result = 0;
+        int end = ((cj + 1) * j_cluster_size + cluster_size - 1) / cluster_size;
+        for (int c = cj * j_cluster_size / cluster_size; c != end; ++c) result |= bits[c];
+        return result;
+    }
+
+    /// Returns true if a cluster pair can contain a pair of a group1 and a group2 atom
+    static bool pair_in_groups(int i_bits, int j_bits)
+    {
+        return ((i_bits & 1) and (j_bits & 2)) or ((i_bits & 2) and (j_bits & 1));
+    }
+
+private:
+
+    std::vector<unsigned char> bits;
+
+};
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_CLUSTERGROUPBITS_H_ */
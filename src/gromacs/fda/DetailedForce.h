@@ -8,39 +8,134 @@
 #ifndef SRC_GROMACS_FDA_DETAILEDFORCE_H_
 #define SRC_GROMACS_FDA_DETAILEDFORCE_H_
 
-#include <array>
+#include <bitset>
+#include <cstdint>
+#include <vector>
 #include "PureInteractionType.h"
 #include "Vector.h"
 
 namespace fda {
 
+/**
+ * Packed detailed force of a single pair
+ *
+ * Only the interaction types present are stored: the bitmask marks the types and
+ * the vector forces are stored contiguously in ascending type order in the arena
+ * of DetailedForceRow, starting at offset.
+ */
 struct DetailedForce
 {
-    /// Default constructor
-    DetailedForce()
-     : number{0}
+    DetailedForce(uint32_t offset = 0, uint8_t mask = 0)
+     : offset(offset), mask(mask)
     {}
 
-    DetailedForce(Vector force_in, PureInteractionType type)
-     : number{0}
+    bool has(int type) const { return mask & (1u << type); }
+
+    /// Number of interaction types
+    int size() const { return std::bitset<8>(mask).count(); }
+
+    /// Position of the force of type within the slab
+    int slot(int type) const { return std::bitset<8>(mask & ((1u << type) - 1)).count(); }
+
+    /// Position of the first force in the arena
+    uint32_t offset;
+
+    /// Bitmask of PureInteractionType indices
+    uint8_t mask;
+};
+
+static_assert(static_cast<int>(PureInteractionType::NUMBER) <= 8, "PureInteractionType must fit into the bitmask of DetailedForce");
+
+/**
+ * Detailed forces of all pairs of a row of DistributedForces
+ *
+ * Most pairs have only one or two interaction types, so that storing a force for
+ * every type wastes memory. If a type is added to a pair, the slab is extended in place
+ * if it is the last one of the arena, otherwise it is moved to the end of the arena.
+ * Moved slabs are not reused before the row is cleared.
+ */
+class DetailedForceRow
+{
+public:
+
+    size_t size() const { return pairs.size(); }
+
+    bool empty() const { return pairs.empty(); }
+
+    void clear()
     {
-        int i = to_index(type);
-        force[i] = force_in;
-        ++number[i];
+        pairs.clear();
+        arena.clear();
     }
 
-    void add(Vector force_in, PureInteractionType type)
+    /// Append a new pair
+    void push_back(Vector const& force, PureInteractionType type)
+    {
+        pairs.emplace_back(arena.size(), 1u << to_index(type));
+        arena.push_back(force);
+    }
+
+    /// Add force to pair p
+    void add(size_t p, Vector const& force, PureInteractionType type)
+    {
+        add(p, force, to_index(type));
+    }
+
+    /// Append pair q of other
+    void push_back(DetailedForceRow const& other, size_t q)
+    {
+        DetailedForce const& f = other.pairs[q];
+        pairs.emplace_back(arena.size(), f.mask);
+        arena.insert(arena.end(), other.arena.begin() + f.offset, other.arena.begin() + f.offset + f.size());
+    }
+
+    /// Add the forces of pair q of other to pair p
+    void add(size_t p, DetailedForceRow const& other, size_t q)
+    {
+        DetailedForce const& f = other.pairs[q];
+        for (int type = 0, s = 0; type != static_cast<int>(PureInteractionType::NUMBER); ++type) {
+            if (f.has(type)) add(p, other.arena[f.offset + s++], type);
+        }
+    }
+
+    /// Call func(type, force) for all interaction types of pair p in ascending order
+    template <class Func>
+    void for_each(size_t p, Func func) const
+    {
+        DetailedForce const& f = pairs[p];
+        for (int type = 0, s = 0; type != static_cast<int>(PureInteractionType::NUMBER); ++type) {
+            if (f.has(type)) func(static_cast<PureInteractionType>(type), arena[f.offset + s++]);
+        }
+    }
+
+private:
+
+    void add(size_t p, Vector const& force, int type)
     {
-        int i = to_index(type);
-        force[i] += force_in;
-        ++number[i];
+        DetailedForce& f = pairs[p];
+        if (f.has(type)) {
+            arena[f.offset + f.slot(type)] += force;
+            return;
+        }
+        int n = f.size();
+        int s = f.slot(type);
+        if (f.offset + n == arena.size()) {
+            arena.insert(arena.begin() + f.offset + s, force);
+        } else {
+            uint32_t offset = arena.size();
+            arena.reserve(offset + n + 1);
+            for (int k = 0; k != s; ++k) arena.push_back(arena[f.offset + k]);
+            arena.push_back(force);
+            for (int k = s; k != n; ++k) arena.push_back(arena[f.offset + k]);
+            f.offset = offset;
+        }
+        f.mask |= 1u << type;
     }
 
-    /// Vector force separated for each interaction type
-    std::array<Vector, static_cast<int>(PureInteractionType::NUMBER)> force;
+    std::vector<DetailedForce> pairs;
 
-    /// Number of forces for each interaction type
-    std::array<int, static_cast<int>(PureInteractionType::NUMBER)> number;
+    /// Slabs of the vector forces of all pairs
+    std::vector<Vector> arena;
 };
 
 } // namespace fda
@@ -6,6 +6,8 @@
  */
 
 #include <algorithm>
+#include <numeric>
+#include "BinaryFormat.h"
 #include "CompatInteractionType.h"
 #include "DistributedForces.h"
 #include "gromacs/math/vec.h"
@@ -14,43 +16,82 @@
 
 namespace fda {
 
-DistributedForces::DistributedForces(int syslen, FDASettings const& fda_settings)
+DistributedForces::DistributedForces(int syslen, FDASettings const& fda_settings, bool direct_punctual_stress)
  : syslen(syslen),
+   active_rows(syslen),
+   scalar_active_rows(syslen),
    indices(syslen),
+   row_index(syslen),
    scalar_indices(syslen),
+   scalar_row_index(syslen),
    scalar(syslen),
    summed(syslen),
    detailed(syslen),
+   direct_punctual_stress(direct_punctual_stress),
+   punctual_stress(direct_punctual_stress ? syslen : 0, 0.0),
    fda_settings(fda_settings)
 {}
 
 void DistributedForces::clear()
 {
-    for (auto& e : indices) e.clear();
-    for (auto& e : summed) e.clear();
-    for (auto& e : detailed) e.clear();
+    for (int i : active_rows.get()) {
+        indices[i].clear();
+        row_index[i].clear();
+        summed[i].clear();
+        detailed[i].clear();
+    }
+    active_rows.clear();
+    std::fill(punctual_stress.begin(), punctual_stress.end(), 0.0);
 }
 
 void DistributedForces::clear_scalar()
 {
-    for (auto& e : scalar_indices) e.clear();
-    for (auto& e : scalar) e.clear();
+    for (int i : scalar_active_rows.get()) {
+        scalar_indices[i].clear();
+        scalar_row_index[i].clear();
+        scalar[i].clear();
+    }
+    scalar_active_rows.clear();
+}
+
+void DistributedForces::swap(DistributedForces& other)
+{
+    if (syslen != other.syslen) throw std::runtime_error("DistributedForces of different size can not be swapped.");
+    std::swap(active_rows, other.active_rows);
+    std::swap(scalar_active_rows, other.scalar_active_rows);
+    indices.swap(other.indices);
+    row_index.swap(other.row_index);
+    scalar_indices.swap(other.scalar_indices);
+    scalar_row_index.swap(other.scalar_row_index);
+    scalar.swap(other.scalar);
+    summed.swap(other.summed);
+    detailed.swap(other.detailed);
+    punctual_stress.swap(other.punctual_stress);
 }
 
 void DistributedForces::add_summed(int i, int j, Vector const& force, InteractionType type)
 {
     if (i > j) throw std::runtime_error("Only upper triangle allowed (i < j).");
 
+    if (direct_punctual_stress) {
+        real scalar_force = norm(force.get_pointer());
+        punctual_stress[i] += scalar_force;
+        punctual_stress[j] += scalar_force;
+        return;
+    }
+
     auto & summed_i = summed[i];
     auto & indices_i = indices[i];
 
-    auto iter = std::find(indices_i.begin(), indices_i.end(), j);
+    int p = row_index[i].find(indices_i, j);
 
-    if (iter == indices_i.end()) {
+    if (p == -1) {
+        if (indices_i.empty()) active_rows.insert(i);
         indices_i.push_back(j);
+        row_index[i].inserted(indices_i);
         summed_i.push_back(Force<Vector>(force, type));
     } else {
-        summed_i[std::distance(indices_i.begin(), iter)] += Force<Vector>(force, type);
+        summed_i[p] += Force<Vector>(force, type);
     }
 }
 
@@ -61,50 +102,181 @@ void DistributedForces::add_detailed(int i, int j, Vector const& force, PureInte
     auto & detailed_i = detailed[i];
     auto & indices_i = indices[i];
 
-    auto iter = std::find(indices_i.begin(), indices_i.end(), j);
+    int p = row_index[i].find(indices_i, j);
 
-    if (iter == indices_i.end()) {
+    if (p == -1) {
+        if (indices_i.empty()) active_rows.insert(i);
         indices_i.push_back(j);
-        detailed_i.push_back(DetailedForce(force, type));
+        row_index[i].inserted(indices_i);
+        detailed_i.push_back(force, type);
     } else {
-        detailed_i[std::distance(indices_i.begin(), iter)].add(force, type);
+        detailed_i.add(p, force, type);
+    }
+}
+
+void DistributedForces::add_row(int i, DistributedForces const& other)
+{
+    auto const& other_indices_i = other.indices[i];
+    auto const& other_summed_i = other.summed[i];
+    auto const& other_detailed_i = other.detailed[i];
+    auto & indices_i = indices[i];
+
+    for (size_t q = 0; q != other_summed_i.size(); ++q) {
+        int p = row_index[i].find(indices_i, other_indices_i[q]);
+        if (p == -1) {
+            indices_i.push_back(other_indices_i[q]);
+            row_index[i].inserted(indices_i);
+            summed[i].push_back(other_summed_i[q]);
+        } else {
+            summed[i][p] += other_summed_i[q];
+        }
+    }
+
+    for (size_t q = 0; q != other_detailed_i.size(); ++q) {
+        int p = row_index[i].find(indices_i, other_indices_i[q]);
+        if (p == -1) {
+            indices_i.push_back(other_indices_i[q]);
+            row_index[i].inserted(indices_i);
+            detailed[i].push_back(other_detailed_i, q);
+        } else {
+            detailed[i].add(p, other_detailed_i, q);
+        }
+    }
+}
+
+void DistributedForces::pack(std::vector<PackedForce>& buffer) const
+{
+    for (int i : active_rows.get()) {
+        auto const& indices_i = indices[i];
+        for (size_t p = 0; p != summed[i].size(); ++p) {
+            Vector const& force = summed[i][p].force;
+            buffer.push_back({i, indices_i[p], summed[i][p].type, {force[0], force[1], force[2]}});
+        }
+        for (size_t p = 0; p != detailed[i].size(); ++p) {
+            detailed[i].for_each(p, [&](PureInteractionType type, Vector const& force) {
+                buffer.push_back({i, indices_i[p], static_cast<int>(type), {force[0], force[1], force[2]}});
+            });
+        }
+    }
+}
+
+void DistributedForces::add_packed(PackedForce const* begin, PackedForce const* end)
+{
+    for (PackedForce const* f = begin; f != end; ++f) {
+        Vector force;
+        for (int d = 0; d != 3; ++d) force[d] = f->force[d];
+        if (fda_settings.one_pair == OnePair::DETAILED) add_detailed(f->i, f->j, force, static_cast<PureInteractionType>(f->type));
+        else add_summed(f->i, f->j, force, f->type);
+    }
+}
+
+namespace {
+
+/// Permutation which sorts the row indices_i, returns false if the row is already sorted
+bool get_sort_order(std::vector<int> const& indices_i, std::vector<size_t>& order)
+{
+    if (std::is_sorted(indices_i.begin(), indices_i.end())) return false;
+    order.resize(indices_i.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&indices_i](size_t p, size_t q){ return indices_i[p] < indices_i[q]; });
+    return true;
+}
+
+template <class T>
+void permute(std::vector<T>& row, std::vector<size_t> const& order)
+{
+    std::vector<T> sorted_row;
+    sorted_row.reserve(order.size());
+    for (size_t p : order) sorted_row.push_back(row[p]);
+    row.swap(sorted_row);
+}
+
+} // namespace
+
+void DistributedForces::sort_rows()
+{
+    std::vector<size_t> order;
+    for (int i : active_rows.get()) {
+        if (!get_sort_order(indices[i], order)) continue;
+        permute(indices[i], order);
+        if (!summed[i].empty()) permute(summed[i], order);
+        if (!detailed[i].empty()) {
+            DetailedForceRow sorted_detailed_i;
+            for (size_t p : order) sorted_detailed_i.push_back(detailed[i], p);
+            std::swap(detailed[i], sorted_detailed_i);
+        }
+        row_index[i].clear();
+        row_index[i].inserted(indices[i]);
+    }
+}
+
+void DistributedForces::sort_scalar_rows()
+{
+    std::vector<size_t> order;
+    for (int i : scalar_active_rows.get()) {
+        if (!get_sort_order(scalar_indices[i], order)) continue;
+        permute(scalar_indices[i], order);
+        permute(scalar[i], order);
+        scalar_row_index[i].clear();
+        scalar_row_index[i].inserted(scalar_indices[i]);
     }
 }
 
 void DistributedForces::write_detailed_vector(std::ostream& os) const
 {
-    for (size_t i = 0; i != detailed.size(); ++i) {
+    if (fda_settings.binary_result_file) {
+        std::vector<BinaryEntry<3>> entries;
+        for (int i : active_rows.get()) {
+            for (size_t p = 0; p != detailed[i].size(); ++p) {
+                detailed[i].for_each(p, [&](PureInteractionType type, Vector const& force) {
+                    entries.push_back({i, indices[i][p], {force[XX], force[YY], force[ZZ]}, from_pure(type)});
+                });
+            }
+        }
+        write_binary_frame(os, entries);
+        return;
+    }
+
+    for (size_t i : active_rows.get()) {
         auto const& detailed_i = detailed[i];
         auto const& indices_i = indices[i];
         for (size_t p = 0; p != detailed_i.size(); ++p) {
             size_t j = indices_i[p];
-            auto const& detailed_j = detailed_i[p];
-            for (int type = 0; type != static_cast<int>(PureInteractionType::NUMBER); ++type) {
-                if (detailed_j.number[type] == 0) continue;
-                Vector const& force = detailed_j.force[type];
+            detailed_i.for_each(p, [&](PureInteractionType type, Vector const& force) {
                 os << i << " " << j << " "
                    << force[XX] << " " << force[YY] << " " << force[ZZ] << " "
-                   << from_pure(static_cast<PureInteractionType>(type)) << std::endl;
-            }
+                   << from_pure(type) << std::endl;
+            });
         }
     }
 }
 
 void DistributedForces::write_detailed_scalar(std::ostream& os, gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box) const
 {
-    for (size_t i = 0; i != detailed.size(); ++i) {
+    if (fda_settings.binary_result_file) {
+        std::vector<BinaryEntry<1>> entries;
+        for (int i : active_rows.get()) {
+            for (size_t p = 0; p != detailed[i].size(); ++p) {
+                int j = indices[i][p];
+                detailed[i].for_each(p, [&](PureInteractionType type, Vector const& force) {
+                    entries.push_back({i, j, {vector2signedscalar(force.get_pointer(), x[i], x[j], box, fda_settings.v2s)}, from_pure(type)});
+                });
+            }
+        }
+        write_binary_frame(os, entries);
+        return;
+    }
+
+    for (size_t i : active_rows.get()) {
         auto const& detailed_i = detailed[i];
         auto const& indices_i = indices[i];
         for (size_t p = 0; p != detailed_i.size(); ++p) {
             size_t j = indices_i[p];
-            auto const& detailed_j = detailed_i[p];
-            for (int type = 0; type != static_cast<int>(PureInteractionType::NUMBER); ++type) {
-                if (detailed_j.number[type] == 0) continue;
-                Vector const& force = detailed_j.force[type];
+            detailed_i.for_each(p, [&](PureInteractionType type, Vector const& force) {
                 os << i << " " << j << " "
                    << vector2signedscalar(force.get_pointer(), x[i], x[j], box, fda_settings.v2s) << " "
-                   << from_pure(static_cast<PureInteractionType>(type)) << std::endl;
-            }
+                   << from_pure(type) << std::endl;
+            });
         }
     }
 }
@@ -112,22 +284,16 @@ void DistributedForces::write_detailed_scalar(std::ostream& os, gmx::PaddedHostV
 void DistributedForces::write_summed_vector(std::ostream& os) const
 {
     if (fda_settings.binary_result_file) {
-        uint num = number_of_interactions(summed);
-        os.write(reinterpret_cast<char*>(&num), sizeof(uint));
-        for (uint i = 0; i != summed.size(); ++i) {
-            if (summed[i].empty()) continue;
-            os.write(reinterpret_cast<char*>(&i), sizeof(uint));
-            uint num_j = summed[i].size();
-            os.write(reinterpret_cast<char*>(&num_j), sizeof(uint));
-            for (uint p = 0; p != num_j; ++p) {
-                uint j = indices[i][p];
-                os.write(reinterpret_cast<char*>(&j), sizeof(uint));
-                os.write(reinterpret_cast<const char*>(summed[i][p].force.get_pointer()), 3*sizeof(real));
-                os.write(reinterpret_cast<const char*>(&summed[i][p].type), sizeof(uint));
+        std::vector<BinaryEntry<3>> entries;
+        for (int i : active_rows.get()) {
+            for (size_t p = 0; p != summed[i].size(); ++p) {
+                Vector const& force = summed[i][p].force;
+                entries.push_back({i, indices[i][p], {force[XX], force[YY], force[ZZ]}, summed[i][p].type});
             }
         }
+        write_binary_frame(os, entries);
     } else {
-        for (size_t i = 0; i != summed.size(); ++i) {
+        for (size_t i : active_rows.get()) {
             auto const& summed_i = summed[i];
             auto const& indices_i = indices[i];
             for (size_t p = 0; p != summed_i.size(); ++p) {
@@ -145,24 +311,18 @@ void DistributedForces::write_summed_vector(std::ostream& os) const
 void DistributedForces::write_summed_scalar(std::ostream& os, gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box) const
 {
     if (fda_settings.binary_result_file) {
-        uint num = number_of_interactions(summed);
-        os.write(reinterpret_cast<char*>(&num), sizeof(uint));
-        for (uint i = 0; i != summed.size(); ++i) {
-            if (summed[i].empty()) continue;
-            os.write(reinterpret_cast<char*>(&i), sizeof(uint));
-            uint num_j = summed[i].size();
-            os.write(reinterpret_cast<char*>(&num_j), sizeof(uint));
-            for (uint p = 0; p != num_j; ++p) {
-                if (std::abs(scalar[i][p].force) < fda_settings.threshold) continue;
-                uint j = indices[i][p];
-                os.write(reinterpret_cast<char*>(&j), sizeof(uint));
-                real scalar = vector2signedscalar(summed[i][p].force.get_pointer(), x[i], x[j], box, fda_settings.v2s);
-                os.write(reinterpret_cast<const char*>(&scalar), sizeof(real));
-                os.write(reinterpret_cast<const char*>(&summed[i][p].type), sizeof(uint));
+        std::vector<BinaryEntry<1>> entries;
+        for (int i : active_rows.get()) {
+            for (size_t p = 0; p != summed[i].size(); ++p) {
+                int j = indices[i][p];
+                real scalar_force = vector2signedscalar(summed[i][p].force.get_pointer(), x[i], x[j], box, fda_settings.v2s);
+                if (std::abs(scalar_force) < fda_settings.threshold) continue;
+                entries.push_back({i, j, {scalar_force}, summed[i][p].type});
             }
         }
+        write_binary_frame(os, entries);
     } else {
-        for (size_t i = 0; i != summed.size(); ++i) {
+        for (size_t i : active_rows.get()) {
             auto const& summed_i = summed[i];
             auto const& indices_i = indices[i];
             for (size_t p = 0; p != summed_i.size(); ++p) {
@@ -182,23 +342,16 @@ void DistributedForces::write_summed_scalar(std::ostream& os, gmx::PaddedHostVec
 void DistributedForces::write_scalar(std::ostream& os) const
 {
     if (fda_settings.binary_result_file) {
-        uint num = number_of_interactions(scalar);
-        os.write(reinterpret_cast<char*>(&num), sizeof(uint));
-        for (uint i = 0; i != scalar.size(); ++i) {
-            if (scalar[i].empty()) continue;
-            os.write(reinterpret_cast<char*>(&i), sizeof(uint));
-            uint num_j = scalar[i].size();
-            os.write(reinterpret_cast<char*>(&num_j), sizeof(uint));
-            for (uint p = 0; p != num_j; ++p) {
+        std::vector<BinaryEntry<1>> entries;
+        for (int i : scalar_active_rows.get()) {
+            for (size_t p = 0; p != scalar[i].size(); ++p) {
                 if (std::abs(scalar[i][p].force) < fda_settings.threshold) continue;
-                uint j = indices[i][p];
-                os.write(reinterpret_cast<char*>(&j), sizeof(uint));
-                os.write(reinterpret_cast<const char*>(&scalar[i][p].force), sizeof(real));
-                os.write(reinterpret_cast<const char*>(&scalar[i][p].type), sizeof(uint));
+                entries.push_back({i, scalar_indices[i][p], {scalar[i][p].force}, scalar[i][p].type});
             }
         }
+        write_binary_frame(os, entries);
     } else {
-        for (size_t i = 0; i != scalar.size(); ++i) {
+        for (size_t i : scalar_active_rows.get()) {
             auto const& scalar_i = scalar[i];
             auto const& scalar_indices_i = scalar_indices[i];
             for (size_t p = 0; p != scalar_i.size(); ++p) {
@@ -216,8 +369,13 @@ void DistributedForces::write_scalar(std::ostream& os) const
 
 void DistributedForces::write_total_forces(std::ostream& os, gmx::PaddedHostVector<gmx::RVec> const& x, bool normalize_psr) const
 {
+    if (direct_punctual_stress) {
+        write_punctual_stress(os, punctual_stress, normalize_psr);
+        return;
+    }
+
     std::vector<real> total_forces(syslen, 0.0);
-    for (size_t i = 0; i != summed.size(); ++i) {
+    for (size_t i : active_rows.get()) {
         auto const& summed_i = summed[i];
         auto const& indices_i = indices[i];
         for (size_t p = 0; p != summed_i.size(); ++p) {
@@ -240,6 +398,11 @@ void DistributedForces::write_total_forces(std::ostream& os, gmx::PaddedHostVect
         }
     }
 
+    write_punctual_stress(os, total_forces, normalize_psr);
+}
+
+void DistributedForces::write_punctual_stress(std::ostream& os, std::vector<real> const& total_forces, bool normalize_psr) const
+{
     // Detect the last non-zero item
     // nb_non_zero_forces holds the index of first zero item or the length of force
     uint nb_non_zero_forces = total_forces.size();
@@ -249,11 +412,12 @@ void DistributedForces::write_total_forces(std::ostream& os, gmx::PaddedHostVect
                 break;
     }
 
-    if (normalize_psr) {
-        for (uint i = 0; i < nb_non_zero_forces; ++i) {
-            if (std::abs(total_forces[i]) != 0.0) total_forces[i] /= fda_settings.residue_size[i];
-        }
-    }
+    // The normalization is applied on output, so that total_forces is not modified
+    auto total_force = [&](uint i) {
+        real value = total_forces[i];
+        if (normalize_psr and std::abs(value) != 0.0) value /= fda_settings.residue_size[i];
+        return value;
+    };
 
     if (fda_settings.binary_result_file) {
     	static bool was_called = false;
@@ -261,15 +425,22 @@ void DistributedForces::write_total_forces(std::ostream& os, gmx::PaddedHostVect
         	os.write(reinterpret_cast<char*>(&nb_non_zero_forces), sizeof(uint));
         	was_called = true;
         }
-        os.write(reinterpret_cast<char*>(&total_forces[0]), nb_non_zero_forces * sizeof(real));
+        if (normalize_psr) {
+            for (uint i = 0; i < nb_non_zero_forces; ++i) {
+                real value = total_force(i);
+                os.write(reinterpret_cast<char*>(&value), sizeof(real));
+            }
+        } else {
+            os.write(reinterpret_cast<const char*>(total_forces.data()), nb_non_zero_forces * sizeof(real));
+        }
     } else {
         bool first_on_line = true;
         for (uint i = 0; i < nb_non_zero_forces; ++i) {
             if (first_on_line) {
-                os << total_forces[i];
+                os << total_force(i);
                 first_on_line = false;
             } else {
-                os << " " << total_forces[i];
+                os << " " << total_force(i);
             }
         }
         os << std::endl;
@@ -280,17 +451,17 @@ void DistributedForces::write_scalar_compat_ascii(std::ostream& os) const
 {
     // Print total number of interactions
     int nb_interactions = 0;
-    for (auto const& s : scalar) nb_interactions += s.size();
+    for (int i : scalar_active_rows.get()) nb_interactions += scalar[i].size();
     os << nb_interactions << std::endl;
 
     // Print atom indices which have interactions
-    for (size_t i = 0; i != scalar.size(); ++i) {
+    for (size_t i : scalar_active_rows.get()) {
         if (!scalar[i].empty()) os << i << " ";
     }
     os << std::endl;
 
     // Print indices
-    for (size_t i = 0; i != scalar.size(); ++i) {
+    for (size_t i : scalar_active_rows.get()) {
         auto const& scalar_i = scalar[i];
         auto const& scalar_indices_i = scalar_indices[i];
         for (size_t p = 0; p != scalar_i.size(); ++p) {
@@ -301,7 +472,7 @@ void DistributedForces::write_scalar_compat_ascii(std::ostream& os) const
     os << std::endl;
 
     // Print forces
-    for (size_t i = 0; i != scalar.size(); ++i) {
+    for (size_t i : scalar_active_rows.get()) {
         auto const& scalar_i = scalar[i];
         for (size_t p = 0; p != scalar_i.size(); ++p) {
             auto const& scalar_j = scalar_i[p];
@@ -311,7 +482,7 @@ void DistributedForces::write_scalar_compat_ascii(std::ostream& os) const
     os << std::endl;
 
     // Print types
-    for (size_t i = 0; i != scalar.size(); ++i) {
+    for (size_t i : scalar_active_rows.get()) {
         auto const& scalar_i = scalar[i];
         for (size_t p = 0; p != scalar_i.size(); ++p) {
             auto const& scalar_j = scalar_i[p];
@@ -325,17 +496,17 @@ void DistributedForces::write_summed_compat_ascii(std::ostream& os, gmx::PaddedH
 {
     // Print total number of interactions
     int nb_interactions = 0;
-    for (auto const& s : summed) nb_interactions += s.size();
+    for (int i : active_rows.get()) nb_interactions += summed[i].size();
     os << nb_interactions << std::endl;
 
     // Print atom indices which have interactions
-    for (size_t i = 0; i != summed.size(); ++i) {
+    for (size_t i : active_rows.get()) {
         if (!summed[i].empty()) os << i << " ";
     }
     os << std::endl;
 
     // Print indices
-    for (size_t i = 0; i != summed.size(); ++i) {
+    for (size_t i : active_rows.get()) {
         auto const& summed_i = summed[i];
         auto const& summed_indices_i = indices[i];
         for (size_t p = 0; p != summed_i.size(); ++p) {
@@ -346,7 +517,7 @@ void DistributedForces::write_summed_compat_ascii(std::ostream& os, gmx::PaddedH
     os << std::endl;
 
     // Print forces
-    for (size_t i = 0; i != summed.size(); ++i) {
+    for (size_t i : active_rows.get()) {
         auto const& summed_i = summed[i];
         auto const& summed_indices_i = indices[i];
         for (size_t p = 0; p != summed_i.size(); ++p) {
@@ -358,7 +529,7 @@ void DistributedForces::write_summed_compat_ascii(std::ostream& os, gmx::PaddedH
     os << std::endl;
 
     // Print types
-    for (size_t i = 0; i != summed.size(); ++i) {
+    for (size_t i : active_rows.get()) {
         auto const& summed_i = summed[i];
         for (size_t p = 0; p != summed_i.size(); ++p) {
             auto const& summed_j = summed_i[p];
@@ -372,17 +543,17 @@ void DistributedForces::write_scalar_compat_bin(std::ostream& os) const
 {
     // Print total number of interactions
     int nb_interactions = 0;
-    for (auto const& s : scalar) nb_interactions += s.size();
+    for (int i : scalar_active_rows.get()) nb_interactions += scalar[i].size();
     os.write(reinterpret_cast<const char*>(&nb_interactions), sizeof(nb_interactions));
 
     // Print atom indices which have interactions
-    for (size_t i = 0; i != scalar.size(); ++i) {
+    for (size_t i : scalar_active_rows.get()) {
         if (!scalar[i].empty())
             os.write(reinterpret_cast<const char*>(&i), sizeof(i));
     }
 
     // Print indices
-    for (size_t i = 0; i != scalar.size(); ++i) {
+    for (size_t i : scalar_active_rows.get()) {
         auto const& scalar_i = scalar[i];
         auto const& scalar_indices_i = scalar_indices[i];
         for (size_t p = 0; p != scalar_i.size(); ++p) {
@@ -393,7 +564,7 @@ void DistributedForces::write_scalar_compat_bin(std::ostream& os) const
     }
 
     // Print forces
-    for (size_t i = 0; i != scalar.size(); ++i) {
+    for (size_t i : scalar_active_rows.get()) {
         auto const& scalar_i = scalar[i];
         for (size_t p = 0; p != scalar_i.size(); ++p) {
             auto const& scalar_j = scalar_i[p];
@@ -402,7 +573,7 @@ void DistributedForces::write_scalar_compat_bin(std::ostream& os) const
     }
 
     // Print types
-    for (size_t i = 0; i != scalar.size(); ++i) {
+    for (size_t i : scalar_active_rows.get()) {
         auto const& scalar_i = scalar[i];
         for (size_t p = 0; p != scalar_i.size(); ++p) {
             auto const& scalar_j = scalar_i[p];
@@ -416,17 +587,17 @@ void DistributedForces::write_summed_compat_bin(std::ostream& os, gmx::PaddedHos
 {
     // Print total number of interactions
     int nb_interactions = 0;
-    for (auto const& s : summed) nb_interactions += s.size();
+    for (int i : active_rows.get()) nb_interactions += summed[i].size();
     os.write(reinterpret_cast<const char*>(&nb_interactions), sizeof(nb_interactions));
 
     // Print atom indices which have interactions
-    for (size_t i = 0; i != summed.size(); ++i) {
+    for (size_t i : scalar_active_rows.get()) {
         if (!scalar[i].empty())
             os.write(reinterpret_cast<const char*>(&i), sizeof(i));
     }
 
     // Print indices
-    for (size_t i = 0; i != summed.size(); ++i) {
+    for (size_t i : active_rows.get()) {
         auto const& summed_i = summed[i];
         auto const& summed_indices_i = indices[i];
         for (size_t p = 0; p != summed_i.size(); ++p) {
@@ -437,7 +608,7 @@ void DistributedForces::write_summed_compat_bin(std::ostream& os, gmx::PaddedHos
     }
 
     // Print forces
-    for (size_t i = 0; i != summed.size(); ++i) {
+    for (size_t i : active_rows.get()) {
         auto const& summed_i = summed[i];
         auto const& summed_indices_i = indices[i];
         for (size_t p = 0; p != summed_i.size(); ++p) {
@@ -449,7 +620,7 @@ void DistributedForces::write_summed_compat_bin(std::ostream& os, gmx::PaddedHos
     }
 
     // Print types
-    for (size_t i = 0; i != summed.size(); ++i) {
+    for (size_t i : active_rows.get()) {
         auto const& summed_i = summed[i];
         for (size_t p = 0; p != summed_i.size(); ++p) {
             auto const& summed_j = summed_i[p];
@@ -462,13 +633,13 @@ void DistributedForces::write_summed_compat_bin(std::ostream& os, gmx::PaddedHos
 void DistributedForces::scalar_real_divide(real divisor)
 {
     real inv = 1.0 / divisor;
-    for (auto& scalar_i : scalar)
-        for (auto& scalar_j : scalar_i) scalar_j.force *= inv;
+    for (int i : scalar_active_rows.get())
+        for (auto& scalar_j : scalar[i]) scalar_j.force *= inv;
 }
 
 void DistributedForces::summed_merge_to_scalar(gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box)
 {
-    for (size_t i = 0; i != summed.size(); ++i) {
+    for (size_t i : active_rows.get()) {
         auto & scalar_i = scalar[i];
         auto & scalar_indices_i = scalar_indices[i];
         auto const& summed_i = summed[i];
@@ -476,24 +647,18 @@ void DistributedForces::summed_merge_to_scalar(gmx::PaddedHostVector<gmx::RVec>
         for (size_t p = 0; p != summed_i.size(); ++p) {
             size_t j = indices_i[p];
             auto const& summed_j = summed_i[p];
-            auto iter = std::find(scalar_indices_i.begin(), scalar_indices_i.end(), j);
+            int q = scalar_row_index[i].find(scalar_indices_i, j);
             Force<real> scalar_force(vector2signedscalar(summed_j.force.get_pointer(), x[i], x[j], box, fda_settings.v2s), summed_j.type);
-            if (iter == scalar_indices_i.end()) {
+            if (q == -1) {
+                if (scalar_indices_i.empty()) scalar_active_rows.insert(i);
                 scalar_indices_i.push_back(j);
+                scalar_row_index[i].inserted(scalar_indices_i);
                 scalar_i.push_back(scalar_force);
             } else {
-                scalar_i[std::distance(scalar_indices_i.begin(), iter)] += scalar_force;
+                scalar_i[q] += scalar_force;
             }
         }
     }
 }
 
-template <class T>
-int DistributedForces::number_of_interactions(std::vector<T> const& v) const
-{
-    int number_of_interactions = 0;
-    for (auto&& e : v) number_of_interactions += e.size();
-    return number_of_interactions;
-}
-
 } // namespace fda
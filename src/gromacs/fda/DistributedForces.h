@@ -12,9 +12,11 @@
 #include "gromacs/gpu_utils/hostallocator.h"
 #include "gromacs/math/vectypes.h"
 #include "gromacs/utility/real.h"
+#include "ActiveRows.h"
 #include "DetailedForce.h"
 #include "FDASettings.h"
 #include "Force.h"
+#include "RowIndex.h"
 #include "Vector.h"
 #include "Vector2Scalar.h"
 
@@ -23,6 +25,18 @@ class FDA;
 
 namespace fda {
 
+/// Force pair in a flat layout for the exchange between MPI ranks
+struct PackedForce
+{
+    int i;
+    int j;
+
+    /// InteractionType for summed forces, PureInteractionType for detailed forces
+    int type;
+
+    real force[3];
+};
+
 /**
  * Storage container for distributed forces
  * Same structure for atom and residue based distribution
@@ -40,8 +54,8 @@ class DistributedForces
 {
 public:
 
-    /// Constructor
-    DistributedForces(int syslen, FDASettings const& fda_settings);
+    /// Constructor, with direct_punctual_stress only the punctual stress per atom/residue is accumulated
+    DistributedForces(int syslen, FDASettings const& fda_settings, bool direct_punctual_stress = false);
 
     /// Clear summed/detailed array for the next frame
     void clear();
@@ -49,10 +63,31 @@ public:
     /// Clear scalar array
     void clear_scalar();
 
+    /// Exchange all forces with other, used to hand over a frame to the writer thread
+    void swap(DistributedForces& other);
+
     void add_summed(int i, int j, Vector const& force, InteractionType type);
 
     void add_detailed(int i, int j, Vector const& force, PureInteractionType type);
 
+    /**
+     * Add the summed and detailed forces of row i of other, used for the reduction of the thread buffers;
+     * row i must already be marked as active, as this function is called concurrently for different rows
+     */
+    void add_row(int i, DistributedForces const& other);
+
+    /// Append all summed or detailed forces to buffer, used to gather the forces of the MPI ranks
+    void pack(std::vector<PackedForce>& buffer) const;
+
+    /// Add the packed forces of another MPI rank
+    void add_packed(PackedForce const* begin, PackedForce const* end);
+
+    /// Sort the pairs of each row by j, the order of the additions depends on the number of threads and ranks
+    void sort_rows();
+
+    /// Same as above for the scalar rows, which collect the pairs in the order of their first frame
+    void sort_scalar_rows();
+
     void write_detailed_vector(std::ostream& os) const;
 
     void write_detailed_scalar(std::ostream& os, gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box) const;
@@ -83,18 +118,30 @@ private:
     friend class ::FDA;
     template <class Base> friend class FDABase;
 
-    template <class T>
-    int number_of_interactions(std::vector<T> const& v) const;
+    /// Write the punctual stress per atom/residue
+    void write_punctual_stress(std::ostream& os, std::vector<real> const& total_forces, bool normalize_psr) const;
 
     /// Total number of atoms/residues in the system
     int syslen;
 
+    /// Rows with summed or detailed entries
+    ActiveRows active_rows;
+
+    /// Rows with scalar entries
+    ActiveRows scalar_active_rows;
+
     /// Indices of second atom (j)
     std::vector<std::vector<int>> indices;
 
+    /// Hashed lookup of the position of j in indices
+    std::vector<RowIndex> row_index;
+
     /// Indices of second atom (j)
     std::vector<std::vector<int>> scalar_indices;
 
+    /// Hashed lookup of the position of j in scalar_indices
+    std::vector<RowIndex> scalar_row_index;
+
     /// Scalar force pairs
     std::vector<std::vector<Force<real>>> scalar;
 
@@ -102,7 +149,13 @@ private:
     std::vector<std::vector<Force<Vector>>> summed;
 
     /// Detailed force pairs
-    std::vector<std::vector<DetailedForce>> detailed;
+    std::vector<DetailedForceRow> detailed;
+
+    /// Summed forces are not stored, but their norm is added to punctual_stress of both particles
+    bool direct_punctual_stress;
+
+    /// Punctual stress per atom/residue, only used with direct_punctual_stress
+    std::vector<real> punctual_stress;
 
     /// FDA settings
     FDASettings const& fda_settings;
@@ -8,11 +8,15 @@
 #include <limits>
 #include <sstream>
 #include "FDA.h"
+#include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/fileio/readinp.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/math/vectypes.h"
+#include "gromacs/mdtypes/commrec.h"
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/real.h"
 #include "gromacs/utility/smalloc.h"
 #include "Utilities.h"
@@ -33,6 +37,8 @@ FDA::FDA(fda::FDASettings const& fda_settings)
                  fda_settings.syslen_residues,
                  fda_settings.residue_based_result_filename,
                  fda_settings),
+   nonbonded_buffers(1, fda::NonbondedBuffer(fda_settings)),
+   cr(nullptr),
    time_averaging_steps(0),
    time_averaging_com(nullptr),
    nsteps(0)
@@ -49,6 +55,39 @@ FDA::~FDA()
 {
     atom_based.write_compat_header(nsteps);
     residue_based.write_compat_header(nsteps);
+    atom_based.write_frame_index();
+    residue_based.write_frame_index();
+}
+
+void FDA::init_threads(int nthreads)
+{
+    atom_based.init_threads(nthreads);
+    residue_based.init_threads(nthreads);
+    nonbonded_buffers.clear();
+    for (int i = 0; i != nthreads; ++i) nonbonded_buffers.emplace_back(fda_settings);
+}
+
+void FDA::init_domain_decomposition(const t_commrec* cr_in)
+{
+    GMX_RELEASE_ASSERT(DOMAINDECOMP(cr_in), "FDA requires a domain decomposition for multiple ranks");
+    cr = cr_in;
+}
+
+int FDA::global_atom_index(int i) const
+{
+    return cr ? cr->dd->globalAtomIndices[i] : i;
+}
+
+gmx::ArrayRef<const int> FDA::get_global_cell_indices(gmx::ArrayRef<const int> cellInv)
+{
+    if (!cr) return cellInv;
+
+    // Filler particles are negative and stay negative
+    global_cell_indices.resize(cellInv.size());
+    for (size_t i = 0; i != cellInv.size(); ++i) {
+        global_cell_indices[i] = cellInv[i] < 0 ? cellInv[i] : global_atom_index(cellInv[i]);
+    }
+    return global_cell_indices;
 }
 
 void FDA::add_bonded_nocheck(int i, int j, fda::InteractionType type, rvec force)
@@ -66,9 +105,9 @@ void FDA::add_bonded_nocheck(int i, int j, fda::InteractionType type, rvec force
                         int_swap(&ri, &rj);
                         clear_rvec(force_residue);
                         rvec_dec(force_residue, force);
-                        residue_based.distributed_forces.add_detailed(ri, rj, force_residue, to_pure(type));
+                        residue_based.get_thread_distributed_forces().add_detailed(ri, rj, force_residue, to_pure(type));
                     } else {
-                        residue_based.distributed_forces.add_detailed(ri, rj, force, to_pure(type));
+                        residue_based.get_thread_distributed_forces().add_detailed(ri, rj, force, to_pure(type));
                     }
                     break;
                 case fda::OnePair::SUMMED:
@@ -76,9 +115,9 @@ void FDA::add_bonded_nocheck(int i, int j, fda::InteractionType type, rvec force
                         int_swap(&ri, &rj);
                         clear_rvec(force_residue);
                         rvec_dec(force_residue, force);
-                        residue_based.distributed_forces.add_summed(ri, rj, force_residue, type);
+                        residue_based.get_thread_distributed_forces().add_summed(ri, rj, force_residue, type);
                     } else {
-                        residue_based.distributed_forces.add_summed(ri, rj, force, type);
+                        residue_based.get_thread_distributed_forces().add_summed(ri, rj, force, type);
                     }
                     break;
             }
@@ -92,10 +131,10 @@ void FDA::add_bonded_nocheck(int i, int j, fda::InteractionType type, rvec force
         }
         switch(fda_settings.one_pair) {
             case fda::OnePair::DETAILED:
-                atom_based.distributed_forces.add_detailed(i, j, force, to_pure(type));
+                atom_based.get_thread_distributed_forces().add_detailed(i, j, force, to_pure(type));
                 break;
             case fda::OnePair::SUMMED:
-                atom_based.distributed_forces.add_summed(i, j, force, type);
+                atom_based.get_thread_distributed_forces().add_summed(i, j, force, type);
                 break;
         }
     }
@@ -105,6 +144,8 @@ void FDA::add_bonded(int i, int j, fda::InteractionType type, rvec force)
 {
     // leave early if the interaction is not interesting
     if (!(fda_settings.type & type)) return;
+    i = global_atom_index(i);
+    j = global_atom_index(j);
     if (!fda_settings.atoms_in_groups(i, j)) return;
     add_bonded_nocheck(i, j, type, force);
 }
@@ -170,18 +211,18 @@ void FDA::add_nonbonded(int i, int j, real pf_coul, real pf_lj, real dx, real dy
                     pf_coul_residue_v[0] = pf_coul_residue * dx;
                     pf_coul_residue_v[1] = pf_coul_residue * dy;
                     pf_coul_residue_v[2] = pf_coul_residue * dz;
-                    residue_based.distributed_forces.add_detailed(ri, rj, pf_coul_residue_v, fda::PureInteractionType::COULOMB);
+                    residue_based.get_thread_distributed_forces().add_detailed(ri, rj, pf_coul_residue_v, fda::PureInteractionType::COULOMB);
                     pf_lj_residue_v[0] = pf_lj_residue * dx;
                     pf_lj_residue_v[1] = pf_lj_residue * dy;
                     pf_lj_residue_v[2] = pf_lj_residue * dz;
-                    residue_based.distributed_forces.add_detailed(ri, rj, pf_lj_residue_v, fda::PureInteractionType::LJ);
+                    residue_based.get_thread_distributed_forces().add_detailed(ri, rj, pf_lj_residue_v, fda::PureInteractionType::LJ);
                     break;
                 case fda::OnePair::SUMMED:
                     pf_lj_coul = pf_lj_residue + pf_coul_residue;
                     pf_coul_residue_v[0] = pf_lj_coul * dx;
                     pf_coul_residue_v[1] = pf_lj_coul * dy;
                     pf_coul_residue_v[2] = pf_lj_coul * dz;
-                    residue_based.distributed_forces.add_summed(ri, rj, pf_coul_residue_v, fda::InteractionType_COULOMB | fda::InteractionType_LJ);
+                    residue_based.get_thread_distributed_forces().add_summed(ri, rj, pf_coul_residue_v, fda::InteractionType_COULOMB | fda::InteractionType_LJ);
                     break;
             }
         }
@@ -199,18 +240,110 @@ void FDA::add_nonbonded(int i, int j, real pf_coul, real pf_lj, real dx, real dy
                 pf_coul_atom_v[0] = pf_coul * dx;
                 pf_coul_atom_v[1] = pf_coul * dy;
                 pf_coul_atom_v[2] = pf_coul * dz;
-                atom_based.distributed_forces.add_detailed(i, j, pf_coul_atom_v, fda::PureInteractionType::COULOMB);
+                atom_based.get_thread_distributed_forces().add_detailed(i, j, pf_coul_atom_v, fda::PureInteractionType::COULOMB);
                 pf_lj_atom_v[0] = pf_lj * dx;
                 pf_lj_atom_v[1] = pf_lj * dy;
                 pf_lj_atom_v[2] = pf_lj * dz;
-                atom_based.distributed_forces.add_detailed(i, j, pf_lj_atom_v, fda::PureInteractionType::LJ);
+                atom_based.get_thread_distributed_forces().add_detailed(i, j, pf_lj_atom_v, fda::PureInteractionType::LJ);
                 break;
             case fda::OnePair::SUMMED:
                 pf_lj_coul = pf_lj + pf_coul;
                 pf_coul_atom_v[0] = pf_lj_coul * dx;
                 pf_coul_atom_v[1] = pf_lj_coul * dy;
                 pf_coul_atom_v[2] = pf_lj_coul * dz;
-                atom_based.distributed_forces.add_summed(i, j, pf_coul_atom_v, fda::InteractionType_COULOMB | fda::InteractionType_LJ);
+                atom_based.get_thread_distributed_forces().add_summed(i, j, pf_coul_atom_v, fda::InteractionType_COULOMB | fda::InteractionType_LJ);
+                break;
+        }
+    }
+}
+
+bool FDA::nonbonded_active() const
+{
+    return (fda_settings.type & (fda::InteractionType_COULOMB | fda::InteractionType_LJ))
+        and (atom_based.PF_or_PS_mode() or residue_based.PF_or_PS_mode());
+}
+
+void FDA::update_cluster_group_bits(int const* cellInv, int natoms)
+{
+    if (nonbonded_active()) cluster_group_bits.update(fda_settings, cellInv, natoms);
+    else cluster_group_bits.clear(natoms);
+}
+
+fda::NonbondedBuffer* FDA::get_thread_nonbonded_buffer()
+{
+    if (!nonbonded_active()) return nullptr;
+
+    int thread = gmx_omp_get_thread_num();
+    GMX_ASSERT(thread < static_cast<int>(nonbonded_buffers.size()), "FDA thread buffers not initialized for this number of threads");
+    return &nonbonded_buffers[thread];
+}
+
+void FDA::drain_nonbonded_buffer(fda::NonbondedBuffer& buffer)
+{
+    // The group checks were done when filling the buffer; the type and mode checks
+    // as well as the lookup of the thread results are done once for the whole block.
+    fda::InteractionType nonbonded_type = fda_settings.type & (fda::InteractionType_COULOMB | fda::InteractionType_LJ);
+    fda::DistributedForces* atom_forces = atom_based.PF_or_PS_mode() ? &atom_based.get_thread_distributed_forces() : nullptr;
+    fda::DistributedForces* residue_forces = residue_based.PF_or_PS_mode() ? &residue_based.get_thread_distributed_forces() : nullptr;
+
+    for (size_t p = 0; p != buffer.size(); ++p) {
+        fda::InteractionType type = buffer.type[p] & nonbonded_type;
+        if (!type) continue;
+
+        int i = buffer.i[p];
+        int j = buffer.j[p];
+
+        // it makes no sense to look at the interaction of a residue to itself
+        if (residue_forces) {
+            int ri = fda_settings.get_atom2residue(i);
+            int rj = fda_settings.get_atom2residue(j);
+            if (ri < rj) add_nonbonded_pair(*residue_forces, ri, rj, type, buffer.fcoul[p], buffer.flj[p], buffer.dx[p], buffer.dy[p], buffer.dz[p]);
+            else if (ri > rj) add_nonbonded_pair(*residue_forces, rj, ri, type, -buffer.fcoul[p], -buffer.flj[p], buffer.dx[p], buffer.dy[p], buffer.dz[p]);
+        }
+
+        if (atom_forces) {
+            if (i < j) add_nonbonded_pair(*atom_forces, i, j, type, buffer.fcoul[p], buffer.flj[p], buffer.dx[p], buffer.dy[p], buffer.dz[p]);
+            else add_nonbonded_pair(*atom_forces, j, i, type, -buffer.fcoul[p], -buffer.flj[p], buffer.dx[p], buffer.dy[p], buffer.dz[p]);
+        }
+    }
+    buffer.clear();
+}
+
+void FDA::add_nonbonded_pair(fda::DistributedForces& forces, int i, int j, fda::InteractionType type,
+    real pf_coul, real pf_lj, real dx, real dy, real dz) const
+{
+    rvec force;
+    if (type == (fda::InteractionType_COULOMB | fda::InteractionType_LJ)) {
+        switch(fda_settings.one_pair) {
+            case fda::OnePair::DETAILED:
+                force[0] = pf_coul * dx;
+                force[1] = pf_coul * dy;
+                force[2] = pf_coul * dz;
+                forces.add_detailed(i, j, force, fda::PureInteractionType::COULOMB);
+                force[0] = pf_lj * dx;
+                force[1] = pf_lj * dy;
+                force[2] = pf_lj * dz;
+                forces.add_detailed(i, j, force, fda::PureInteractionType::LJ);
+                break;
+            case fda::OnePair::SUMMED:
+                real pf_lj_coul = pf_lj + pf_coul;
+                force[0] = pf_lj_coul * dx;
+                force[1] = pf_lj_coul * dy;
+                force[2] = pf_lj_coul * dz;
+                forces.add_summed(i, j, force, type);
+                break;
+        }
+    } else {
+        real pf = type == fda::InteractionType_COULOMB ? pf_coul : pf_lj;
+        force[0] = pf * dx;
+        force[1] = pf * dy;
+        force[2] = pf * dz;
+        switch(fda_settings.one_pair) {
+            case fda::OnePair::DETAILED:
+                forces.add_detailed(i, j, force, to_pure(type));
+                break;
+            case fda::OnePair::SUMMED:
+                forces.add_summed(i, j, force, type);
                 break;
         }
     }
@@ -326,30 +459,22 @@ void FDA::add_dihedral(int i, int j, int k, int l, rvec f_i, rvec f_j, rvec f_k,
     add_bonded(k, l, fda::InteractionType_DIHEDRAL, f_k_l);
 }
 
-void FDA::add_virial(int ai, tensor v, real s)
+void FDA::add_virial(int ai, fda::VirialStress::Packed const& v, real s)
 {
-    // Only symmetric tensor is used, therefore full multiplication is not as efficient
-    // atom_vir[ai] += s * v;
-
-    atom_based.virial_stress[ai](XX, XX) += s * v[XX][XX];
-    atom_based.virial_stress[ai](YY, YY) += s * v[YY][YY];
-    atom_based.virial_stress[ai](ZZ, ZZ) += s * v[ZZ][ZZ];
-    atom_based.virial_stress[ai](XX, YY) += s * v[XX][YY];
-    atom_based.virial_stress[ai](XX, ZZ) += s * v[XX][ZZ];
-    atom_based.virial_stress[ai](YY, ZZ) += s * v[YY][ZZ];
+    atom_based.get_virial_stress(gmx_omp_get_thread_num()).add(global_atom_index(ai), v, s);
 }
 
 void FDA::add_virial_bond(int ai, int aj, real f, real dx, real dy, real dz)
 {
     if (!atom_based.VS_mode()) return;
 
-    tensor v;
-    v[XX][XX] = dx * dx * f;
-    v[YY][YY] = dy * dy * f;
-    v[ZZ][ZZ] = dz * dz * f;
-    v[XX][YY] = dx * dy * f;
-    v[XX][ZZ] = dx * dz * f;
-    v[YY][ZZ] = dy * dz * f;
+    fda::VirialStress::Packed v;
+    v.v[fda::VirialStress::xx] = dx * dx * f;
+    v.v[fda::VirialStress::yy] = dy * dy * f;
+    v.v[fda::VirialStress::zz] = dz * dz * f;
+    v.v[fda::VirialStress::xy] = dx * dy * f;
+    v.v[fda::VirialStress::xz] = dx * dz * f;
+    v.v[fda::VirialStress::yz] = dy * dz * f;
     add_virial(ai, v, HALF);
     add_virial(aj, v, HALF);
 }
@@ -359,13 +484,13 @@ void FDA::add_virial_angle(int ai, int aj, int ak,
 {
     if (!atom_based.VS_mode()) return;
 
-    tensor v;
-    v[XX][XX] = r_ij[XX] * f_i[XX] + r_kj[XX] * f_k[XX];
-    v[YY][YY] = r_ij[YY] * f_i[YY] + r_kj[YY] * f_k[YY];
-    v[ZZ][ZZ] = r_ij[ZZ] * f_i[ZZ] + r_kj[ZZ] * f_k[ZZ];
-    v[XX][YY] = r_ij[XX] * f_i[YY] + r_kj[XX] * f_k[YY];
-    v[XX][ZZ] = r_ij[XX] * f_i[ZZ] + r_kj[XX] * f_k[ZZ];
-    v[YY][ZZ] = r_ij[YY] * f_i[ZZ] + r_kj[YY] * f_k[ZZ];
+    fda::VirialStress::Packed v;
+    v.v[fda::VirialStress::xx] = r_ij[XX] * f_i[XX] + r_kj[XX] * f_k[XX];
+    v.v[fda::VirialStress::yy] = r_ij[YY] * f_i[YY] + r_kj[YY] * f_k[YY];
+    v.v[fda::VirialStress::zz] = r_ij[ZZ] * f_i[ZZ] + r_kj[ZZ] * f_k[ZZ];
+    v.v[fda::VirialStress::xy] = r_ij[XX] * f_i[YY] + r_kj[XX] * f_k[YY];
+    v.v[fda::VirialStress::xz] = r_ij[XX] * f_i[ZZ] + r_kj[XX] * f_k[ZZ];
+    v.v[fda::VirialStress::yz] = r_ij[YY] * f_i[ZZ] + r_kj[YY] * f_k[ZZ];
     add_virial(ai, v, THIRD);
     add_virial(aj, v, THIRD);
     add_virial(ak, v, THIRD);
@@ -377,14 +502,14 @@ void FDA::add_virial_dihedral(int i, int j, int k, int l,
     if (!atom_based.VS_mode()) return;
 
     rvec r_lj;
-    tensor v;
+    fda::VirialStress::Packed v;
     rvec_sub(r_kj, r_kl, r_lj);
-    v[XX][XX] = r_ij[XX] * f_i[XX] + r_kj[XX] * f_k[XX] + r_lj[XX] * f_l[XX];
-    v[YY][YY] = r_ij[YY] * f_i[YY] + r_kj[YY] * f_k[YY] + r_lj[YY] * f_l[YY];
-    v[ZZ][ZZ] = r_ij[ZZ] * f_i[ZZ] + r_kj[ZZ] * f_k[ZZ] + r_lj[ZZ] * f_l[ZZ];
-    v[XX][YY] = r_ij[XX] * f_i[YY] + r_kj[XX] * f_k[YY] + r_lj[XX] * f_l[YY];
-    v[XX][ZZ] = r_ij[XX] * f_i[ZZ] + r_kj[XX] * f_k[ZZ] + r_lj[XX] * f_l[ZZ];
-    v[YY][ZZ] = r_ij[YY] * f_i[ZZ] + r_kj[YY] * f_k[ZZ] + r_lj[YY] * f_l[ZZ];
+    v.v[fda::VirialStress::xx] = r_ij[XX] * f_i[XX] + r_kj[XX] * f_k[XX] + r_lj[XX] * f_l[XX];
+    v.v[fda::VirialStress::yy] = r_ij[YY] * f_i[YY] + r_kj[YY] * f_k[YY] + r_lj[YY] * f_l[YY];
+    v.v[fda::VirialStress::zz] = r_ij[ZZ] * f_i[ZZ] + r_kj[ZZ] * f_k[ZZ] + r_lj[ZZ] * f_l[ZZ];
+    v.v[fda::VirialStress::xy] = r_ij[XX] * f_i[YY] + r_kj[XX] * f_k[YY] + r_lj[XX] * f_l[YY];
+    v.v[fda::VirialStress::xz] = r_ij[XX] * f_i[ZZ] + r_kj[XX] * f_k[ZZ] + r_lj[XX] * f_l[ZZ];
+    v.v[fda::VirialStress::yz] = r_ij[YY] * f_i[ZZ] + r_kj[YY] * f_k[ZZ] + r_lj[YY] * f_l[ZZ];
     add_virial(i, v, QUARTER);
     add_virial(j, v, QUARTER);
     add_virial(k, v, QUARTER);
@@ -393,12 +518,27 @@ void FDA::add_virial_dihedral(int i, int j, int k, int l,
 
 void FDA::save_and_write_scalar_time_averages(gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, const gmx_mtop_t *mtop)
 {
+    // Collect the contributions of all OpenMP threads of this frame
+    atom_based.reduce_threads();
+    residue_based.reduce_threads();
+
+    // With domain decomposition only the master rank writes the forces of all ranks
+    if (cr) {
+        atom_based.reduce_ranks(cr);
+        residue_based.reduce_ranks(cr);
+        if (!MASTER(cr)) return;
+    }
+
+    // Write the pairs in the same order for any number of threads and ranks
+    atom_based.distributed_forces.sort_rows();
+    residue_based.distributed_forces.sort_rows();
+
     if (fda_settings.time_averaging_period != 1) {
         if (atom_based.PF_or_PS_mode()) {
             atom_based.distributed_forces.summed_merge_to_scalar(x, box);
         }
         if (residue_based.PF_or_PS_mode()) {
-            gmx::PaddedHostVector<gmx::RVec> com = get_residues_com(x, mtop);
+            gmx::PaddedHostVector<gmx::RVec> const& com = get_residues_com(x, mtop);
             residue_based.distributed_forces.summed_merge_to_scalar(com, box);
             for (int i = 0; i != fda_settings.syslen_residues; ++i) {
                 rvec_inc(time_averaging_com[i], com[i]);
@@ -422,6 +562,7 @@ void FDA::write_scalar_time_averages()
 
     if (atom_based.PF_or_PS_mode()) {
         atom_based.distributed_forces.scalar_real_divide(time_averaging_steps);
+        atom_based.distributed_forces.sort_scalar_rows();
         if (atom_based.compatibility_mode())
             atom_based.write_frame_scalar_compat(nsteps);
         else
@@ -431,6 +572,7 @@ void FDA::write_scalar_time_averages()
 
     if (residue_based.PF_or_PS_mode()) {
         residue_based.distributed_forces.scalar_real_divide(time_averaging_steps);
+        residue_based.distributed_forces.sort_scalar_rows();
         //pf_x_real_div(time_averaging_com, fda_settings.syslen_residues, time_averaging_steps);
         for (size_t i = 0; i != residue_based.distributed_forces.scalar.size(); ++i)
             svdiv(time_averaging_steps, time_averaging_com[i]);
@@ -449,53 +591,15 @@ void FDA::write_scalar_time_averages()
 void FDA::write_frame(gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, const gmx_mtop_t *mtop)
 {
     atom_based.write_frame(x, box, nsteps);
-    residue_based.write_frame(get_residues_com(x, mtop), box, nsteps);
+    if (fda_settings.residue_based_result_type != ResultType::NO)
+        residue_based.write_frame(get_residues_com(x, mtop), box, nsteps);
     ++nsteps;
 }
 
-gmx::PaddedHostVector<gmx::RVec> FDA::get_residues_com(gmx::PaddedHostVector<gmx::RVec> const& x, const gmx_mtop_t *mtop) const
+gmx::PaddedHostVector<gmx::RVec> const& FDA::get_residues_com(gmx::PaddedHostVector<gmx::RVec> const& x, const gmx_mtop_t *mtop)
 {
-    int mol_index, d;
-    int i, atom_index, atom_global_index, residue_global_index;
-    const t_atoms *atoms;
-    t_atom *atom_info;
-    rvec r;
-
-    std::vector<real> mass(fda_settings.syslen_residues);
-    gmx::PaddedHostVector<gmx::RVec> com(fda_settings.syslen_residues);
-
-    for (i = 0; i < fda_settings.syslen_residues; i++) {
-        mass[i] = 0.0;
-        for (d = 0; d < DIM; d++)
-            com[i][d] = 0.0;
-    }
-
-    atom_global_index = 0;
-    for (auto const& mb : mtop->molblock) {
-        for (mol_index = 0; mol_index < mb.nmol; mol_index++) {
-        atoms = &mtop->moltype[mb.type].atoms;
-            for(atom_index = 0; atom_index < atoms->nr; atom_index++) {
-                if (fda_settings.atom_in_groups(atom_global_index)) {
-                    residue_global_index = fda_settings.atom_2_residue[atom_global_index];
-                    atom_info=&atoms->atom[atom_index];
-                    mass[residue_global_index] += atom_info->m;
-                    svmul(atom_info->m, x[atom_global_index], r);
-                    rvec_inc(com[residue_global_index], r);
-                }
-                atom_global_index++;
-            }
-        }
-    }
-
-    // There might be residues with no interesting atoms, so their mass would be set to the initial 0.0;
-    // float/double comparison can be tricky in general, but here it's used only to prevent division by 0
-    for (i = 0; i < fda_settings.syslen_residues; ++i) {
-        if (mass[i] != 0.0)
-            for (d = 0; d < DIM; d++)
-                com[i][d] /= mass[i];
-    }
-
-    return com;
+    if (!residue_com) residue_com = std::make_unique<fda::ResidueCOM>(fda_settings, *mtop);
+    return residue_com->compute(x);
 }
 
 void fda_add_nonbonded(FDA *fda, int i, int j, real pf_coul, real pf_lj, real dx, real dy, real dz)
@@ -13,13 +13,20 @@
 
 #ifdef __cplusplus
 #include <cstdio>
+#include <memory>
 #include <vector>
+#include "ClusterGroupBits.h"
 #include "FDABase.h"
 #include "FDASettings.h"
 #include "gromacs/gpu_utils/hostallocator.h"
 #include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/utility/arrayref.h"
 #include "InteractionType.h"
+#include "NonbondedBuffer.h"
 #include "PureInteractionType.h"
+#include "ResidueCOM.h"
+
+struct t_commrec;
 
 class FDA {
 public:
@@ -28,9 +35,15 @@ public:
     FDA(fda::FDASettings const& fda_settings = fda::FDASettings());
 
     /// Destructor
-    /// Write compat footer
+    /// Write compat footer and the frame index of binary files
     ~FDA();
 
+    /**
+     * Allocate separate buffers for each OpenMP thread calling the add functions,
+     * they are reduced once per frame in save_and_write_scalar_time_averages
+     */
+    void init_threads(int nthreads);
+
     /**
      * Checking is symmetrical for atoms i and j; one of them has to be from g1, the other one from g2;
      * the check below makes the atoms equivalent, make them always have the same order (i,j) and not (j,i) where i < j;
@@ -62,15 +75,42 @@ public:
      */
     void add_nonbonded(int i, int j, real pf_coul, real pf_lj, real dx, real dy, real dz);
 
+    /**
+     * Enable the domain decomposition: the local atom indices of the force routines are mapped
+     * to global ones and the forces of all ranks are gathered on the master rank at each frame
+     */
+    void init_domain_decomposition(const t_commrec* cr);
+
+    /// Map the local atom indices of the nbnxm atoms to global ones, returns cellInv without domain decomposition
+    gmx::ArrayRef<const int> get_global_cell_indices(gmx::ArrayRef<const int> cellInv);
+
+    /// Precompute the FDA group bits of the nonbonded clusters, cellInv maps the natoms nbnxm atoms to the global atom index
+    void update_cluster_group_bits(int const* cellInv, int natoms);
+
+    /// FDA group bits of the nonbonded clusters, all zero if no pairwise nonbonded forces are requested
+    fda::ClusterGroupBits const& get_cluster_group_bits() const { return cluster_group_bits; }
+
+    /**
+     * Side buffer of the calling OpenMP thread for the nonbonded kernels, which append whole
+     * i-cluster x j-cluster blocks; returns nullptr if no pairwise nonbonded forces are requested
+     */
+    fda::NonbondedBuffer* get_thread_nonbonded_buffer();
+
+    /**
+     * Batched version of add_nonbonded for all interactions of the buffer, which is cleared afterwards.
+     * The interaction type and result mode are checked once per buffer instead of once per pair.
+     */
+    void drain_nonbonded_buffer(fda::NonbondedBuffer& buffer);
+
     void add_angle(int ai, int aj, int ak, rvec f_i, rvec f_j, rvec f_k);
 
     void add_dihedral(int i, int j, int k, int l, rvec f_i, rvec f_j, rvec f_k, rvec f_l);
 
     /**
-     * The atom virial can be expressed as a 6-real tensor, as it's symmetric.
-     * To avoid defining a new tensor type, the 9-real tensor is used instead.
+     * The atom virial is symmetric and therefore packed into its 6 independent components,
+     * s * v is added to the virial stress buffer of the calling OpenMP thread.
      */
-    void add_virial(int ai, tensor v, real s);
+    void add_virial(int ai, fda::VirialStress::Packed const& v, real s);
 
     /**
      * Origin on j, but for 2 atoms it doesn't matter.
@@ -127,9 +167,9 @@ private:
      * Computes the COM for residues in system;
      * only the atoms for which sys_in_g is non-zero are considered, such that the COM might
      * not express the COM of the whole residue but the COM of the atoms of the residue which
-     * are interesting for PF
+     * are interesting for PF. The plan of the group atoms is built from mtop on the first call.
      */
-    gmx::PaddedHostVector<gmx::RVec> get_residues_com(gmx::PaddedHostVector<gmx::RVec> const& x, const gmx_mtop_t *mtop) const;
+    gmx::PaddedHostVector<gmx::RVec> const& get_residues_com(gmx::PaddedHostVector<gmx::RVec> const& x, const gmx_mtop_t *mtop);
 
     /// Settings
     fda::FDASettings const& fda_settings;
@@ -140,10 +180,35 @@ private:
     /// Residue-based operation
     fda::FDABase<fda::Residue> residue_based;
 
+    /// Global index of the local atom i
+    int global_atom_index(int i) const;
+
+    /// Returns true if pairwise Coulomb or LJ forces are requested
+    bool nonbonded_active() const;
+
+    /// Add a nonbonded pair with i < j and the forces already oriented to forces
+    void add_nonbonded_pair(fda::DistributedForces& forces, int i, int j, fda::InteractionType type,
+        real pf_coul, real pf_lj, real dx, real dy, real dz) const;
+
+    /// Nonbonded side buffers of the kernels, one per OpenMP thread
+    std::vector<fda::NonbondedBuffer> nonbonded_buffers;
+
+    /// Group bits of the nonbonded clusters
+    fda::ClusterGroupBits cluster_group_bits;
+
+    /// Communication record of the domain decomposition, nullptr without
+    const t_commrec* cr;
+
+    /// Global atom indices of the nbnxm atoms with domain decomposition
+    std::vector<int> global_cell_indices;
+
     /// Counter for current step, incremented for every call of save_and_write_scalar_time_averages()
     /// When it reaches time_averages_steps, data is written
     int time_averaging_steps;
 
+    /// Residue COM of the group atoms, only allocated for residue-based forces
+    std::unique_ptr<fda::ResidueCOM> residue_com;
+
     /// Averaged residue COM coordinates over steps, needed for COM calculations
     /// Only initialized when residue_based_forces is non-zero
     rvec *time_averaging_com;
@@ -5,42 +5,204 @@
  *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
  */
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include "BinaryFormat.h"
 #include "FDABase.h"
+#include "gromacs/domdec/domdec_network.h"
+#include "gromacs/domdec/domdec_struct.h"
+#include "gromacs/gmxlib/network.h"
 #include "gromacs/math/vec.h"
+#include "gromacs/mdtypes/commrec.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "PureInteractionType.h"
 #include "Utilities.h"
 
 namespace fda {
 
+void Atom::reduce_threads()
+{
+    if (thread_virial_stress.empty()) return;
+
+    // Atoms are independent, so the reduction itself can be distributed over the threads
+    int nthreads = thread_virial_stress.size() + 1;
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+    for (int t = 0; t < nthreads; ++t) {
+        int begin = static_cast<int64_t>(virial_stress.size()) * t / nthreads;
+        int end = static_cast<int64_t>(virial_stress.size()) * (t + 1) / nthreads;
+        for (auto& thread_virial_stress_t : thread_virial_stress) virial_stress.add_and_clear(thread_virial_stress_t, begin, end);
+    }
+}
+
+void Atom::reduce_ranks(const t_commrec* cr)
+{
+    gmx_sum(virial_stress.data_size(), virial_stress.data(), cr);
+    if (!MASTER(cr)) virial_stress.clear();
+}
+
 template <class Base>
 FDABase<Base>::FDABase(ResultType result_type, int syslen, std::string const& result_filename, FDASettings const& fda_settings)
  : Base(result_type == ResultType::VIRIAL_STRESS or result_type == ResultType::VIRIAL_STRESS_VON_MISES, syslen),
    result_type(result_type),
    syslen(syslen),
-   distributed_forces(syslen, fda_settings),
-   fda_settings(fda_settings)
+   distributed_forces(syslen, fda_settings, result_type == ResultType::PUNCTUAL_STRESS and fda_settings.direct_punctual_stress),
+   nthreads(1),
+   fda_settings(fda_settings),
+   nb_written_frames(0)
 {
+    // The other ranks of a domain decomposition send their forces to the master rank
+    if (!fda_settings.master_rank) return;
+
     result_file << std::scientific << std::setprecision(6);
     if (PF_or_PS_mode()) make_backup(result_filename.c_str());
-    if (fda_settings.binary_result_file) {
+    if (binary_format()) {
+        result_file.open(result_filename, std::ifstream::binary);
+        BinaryHeader header;
+        header.syslen = syslen;
+        header.result_type = static_cast<int32_t>(result_type);
+        header.force_size = result_type == ResultType::PAIRWISE_FORCES_VECTOR ? 3 : 1;
+        header.entry_size = result_type == ResultType::PAIRWISE_FORCES_VECTOR ? sizeof(BinaryEntry<3>) : sizeof(BinaryEntry<1>);
+        if (fda_settings.groupnames) {
+            if (fda_settings.index_group1 >= 0) header.group1 = fda_settings.groupnames[fda_settings.index_group1];
+            if (fda_settings.index_group2 >= 0) header.group2 = fda_settings.groupnames[fda_settings.index_group2];
+        }
+        write_binary_header(result_file, header);
+    } else if (fda_settings.binary_result_file) {
     	result_file.open(result_filename, std::ifstream::binary);
     	char b = 'b';
 		result_file.write(&b, 1);
-	    if (result_type == ResultType::PUNCTUAL_STRESS) {
-	    	result_file.write(reinterpret_cast<char*>(&syslen), sizeof(uint));
+	    if (stress_mode()) {
+	        // Number of values per frame, the virial stress has six values per atom
+	        uint nb_values = result_type == ResultType::VIRIAL_STRESS ? 6 * syslen : syslen;
+	    	result_file.write(reinterpret_cast<char*>(&nb_values), sizeof(uint));
 	    }
     } else {
     	result_file.open(result_filename);
     	result_file << result_type << std::endl;
     }
     write_compat_header(1);
+
+    if (fda_settings.async_write_frames > 0 and fda_settings.time_averaging_period == 1 and PF_or_PS_mode()) {
+        frames.reserve(fda_settings.async_write_frames);
+        for (int i = 0; i != fda_settings.async_write_frames; ++i) frames.emplace_back(syslen, distributed_forces.fda_settings, distributed_forces.direct_punctual_stress);
+        writer = std::make_unique<AsyncWriter>();
+    }
+}
+
+template <class Base>
+void FDABase<Base>::init_threads(int nthreads_in)
+{
+    nthreads = std::max(nthreads_in, 1);
+    thread_distributed_forces.clear();
+    if (PF_or_PS_mode()) {
+        thread_distributed_forces.reserve(nthreads - 1);
+        for (int t = 1; t < nthreads; ++t) thread_distributed_forces.emplace_back(syslen, distributed_forces.fda_settings, distributed_forces.direct_punctual_stress);
+    }
+    if (VS_mode()) Base::init_threads(nthreads);
+}
+
+template <class Base>
+DistributedForces& FDABase<Base>::get_thread_distributed_forces()
+{
+    int thread = gmx_omp_get_thread_num();
+    if (thread == 0) return distributed_forces;
+    GMX_ASSERT(thread < nthreads, "FDA thread buffers are not initialized for this number of OpenMP threads");
+    return thread_distributed_forces[thread - 1];
+}
+
+template <class Base>
+void FDABase<Base>::reduce_threads()
+{
+    if (nthreads == 1) return;
+
+    if (distributed_forces.direct_punctual_stress) {
+        std::vector<real>& punctual_stress = distributed_forces.punctual_stress;
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+        for (int i = 0; i < syslen; ++i) {
+            for (auto& thread_forces : thread_distributed_forces) {
+                punctual_stress[i] += thread_forces.punctual_stress[i];
+                thread_forces.punctual_stress[i] = 0.0;
+            }
+        }
+    } else if (PF_or_PS_mode()) {
+        // Only the rows used by any thread need to be reduced
+        for (auto const& thread_forces : thread_distributed_forces) {
+            for (int i : thread_forces.active_rows.get()) distributed_forces.active_rows.insert(i);
+        }
+        std::vector<int> const& rows = distributed_forces.active_rows.get();
+
+        // Rows are independent, so the reduction itself can be distributed over the threads
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+        for (size_t r = 0; r < rows.size(); ++r) {
+            try {
+                for (auto const& thread_forces : thread_distributed_forces) distributed_forces.add_row(rows[r], thread_forces);
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+        }
+        for (auto& thread_forces : thread_distributed_forces) thread_forces.clear();
+    }
+    if (VS_mode()) Base::reduce_threads();
+}
+
+template <class Base>
+void FDABase<Base>::reduce_ranks(const t_commrec* cr)
+{
+    if (distributed_forces.direct_punctual_stress) {
+        // Without pair lists a plain sum over all ranks is sufficient
+        gmx_sum(syslen, distributed_forces.punctual_stress.data(), cr);
+        if (!MASTER(cr)) distributed_forces.clear();
+    } else if (PF_or_PS_mode()) {
+        const gmx_domdec_t* dd = cr->dd;
+
+        // The master rank keeps its own forces in distributed_forces
+        std::vector<PackedForce> buffer;
+        if (!MASTER(cr)) distributed_forces.pack(buffer);
+
+        int nbytes = buffer.size() * sizeof(PackedForce);
+        std::vector<int> rank_nbytes(MASTER(cr) ? dd->nnodes : 0);
+        dd_gather(dd, sizeof(int), &nbytes, rank_nbytes.data());
+
+        std::vector<int> displacements(rank_nbytes.size(), 0);
+        for (size_t r = 1; r < rank_nbytes.size(); ++r) displacements[r] = displacements[r - 1] + rank_nbytes[r - 1];
+        size_t total_nbytes = rank_nbytes.empty() ? 0 : displacements.back() + rank_nbytes.back();
+
+        std::vector<PackedForce> all_forces(total_nbytes / sizeof(PackedForce) + 1);
+        dd_gatherv(dd, nbytes, buffer.data(), rank_nbytes.data(), displacements.data(), all_forces.data());
+
+        if (MASTER(cr)) distributed_forces.add_packed(all_forces.data(), all_forces.data() + all_forces.size() - 1);
+        else distributed_forces.clear();
+    }
+    if (VS_mode()) Base::reduce_ranks(cr);
 }
 
 template <class Base>
 void FDABase<Base>::write_frame(gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, int nsteps)
+{
+    if (!writer) {
+        write_frame(distributed_forces, x, box, nsteps);
+        return;
+    }
+
+    // Wait until the writer thread has finished the previous frame of this buffer
+    writer->wait(frames.size() - 1);
+    Frame& frame = frames[nb_written_frames++ % frames.size()];
+    frame.forces.swap(distributed_forces);
+    frame.x = x;
+    copy_mat(box, frame.box);
+    frame.nsteps = nsteps;
+
+    writer->push([this, &frame]{
+        write_frame(frame.forces, frame.x, frame.box, frame.nsteps);
+        frame.forces.clear();
+    });
+}
+
+template <class Base>
+void FDABase<Base>::write_frame(DistributedForces const& forces, gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, int nsteps)
 {
     switch (fda_settings.one_pair) {
         case OnePair::DETAILED:
@@ -49,10 +211,10 @@ void FDABase<Base>::write_frame(gmx::PaddedHostVector<gmx::RVec> const& x, const
                     // do nothing
                     break;
                 case ResultType::PAIRWISE_FORCES_VECTOR:
-                    write_frame_detailed(x, box, true, nsteps);
+                    write_frame_detailed(forces, x, box, true, nsteps);
                     break;
                 case ResultType::PAIRWISE_FORCES_SCALAR:
-                    write_frame_detailed(x, box, false, nsteps);
+                    write_frame_detailed(forces, x, box, false, nsteps);
                     break;
                 case ResultType::PUNCTUAL_STRESS:
                     gmx_fatal(FARGS, "Punctual stress is not supported for detailed output.\n");
@@ -77,13 +239,13 @@ void FDABase<Base>::write_frame(gmx::PaddedHostVector<gmx::RVec> const& x, const
                     // do nothing
                     break;
                 case ResultType::PAIRWISE_FORCES_VECTOR:
-                    write_frame_summed(x, box, true, nsteps);
+                    write_frame_summed(forces, x, box, true, nsteps);
                     break;
                 case ResultType::PAIRWISE_FORCES_SCALAR:
-                    write_frame_summed(x, box, false, nsteps);
+                    write_frame_summed(forces, x, box, false, nsteps);
                     break;
                 case ResultType::PUNCTUAL_STRESS:
-                    write_total_forces(x);
+                    write_total_forces(forces, x);
                     break;
                 case ResultType::VIRIAL_STRESS:
                     write_virial_sum();
@@ -95,7 +257,7 @@ void FDABase<Base>::write_frame(gmx::PaddedHostVector<gmx::RVec> const& x, const
                     gmx_fatal(FARGS, "Compatibility binary mode is not supported for summed output.\n");
                     break;
                 case ResultType::COMPAT_ASCII:
-                    write_frame_summed_compat(x, box, nsteps);
+                    write_frame_summed_compat(forces, x, box, nsteps);
                     break;
             }
             break;
@@ -103,23 +265,23 @@ void FDABase<Base>::write_frame(gmx::PaddedHostVector<gmx::RVec> const& x, const
 }
 
 template <class Base>
-void FDABase<Base>::write_frame_detailed(gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, bool print_vector, int nsteps)
+void FDABase<Base>::write_frame_detailed(DistributedForces const& forces, gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, bool print_vector, int nsteps)
 {
 	write_frame_number(nsteps);
     if (print_vector)
-        distributed_forces.write_detailed_vector(result_file);
+        forces.write_detailed_vector(result_file);
     else
-        distributed_forces.write_detailed_scalar(result_file, x, box);
+        forces.write_detailed_scalar(result_file, x, box);
 }
 
 template <class Base>
-void FDABase<Base>::write_frame_summed(gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, bool print_vector, int nsteps)
+void FDABase<Base>::write_frame_summed(DistributedForces const& forces, gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, bool print_vector, int nsteps)
 {
 	write_frame_number(nsteps);
     if (print_vector)
-        distributed_forces.write_summed_vector(result_file);
+        forces.write_summed_vector(result_file);
     else
-        distributed_forces.write_summed_scalar(result_file, x, box);
+        forces.write_summed_scalar(result_file, x, box);
 }
 
 template <class Base>
@@ -130,21 +292,22 @@ void FDABase<Base>::write_frame_scalar(int nsteps)
 }
 
 template <>
-void FDABase<Atom>::write_total_forces(gmx::PaddedHostVector<gmx::RVec> const& x)
+void FDABase<Atom>::write_total_forces(DistributedForces const& forces, gmx::PaddedHostVector<gmx::RVec> const& x)
 {
-    distributed_forces.write_total_forces(result_file, x);
+    forces.write_total_forces(result_file, x);
 }
 
 template <>
-void FDABase<Residue>::write_total_forces(gmx::PaddedHostVector<gmx::RVec> const& x)
+void FDABase<Residue>::write_total_forces(DistributedForces const& forces, gmx::PaddedHostVector<gmx::RVec> const& x)
 {
-    distributed_forces.write_total_forces(result_file, x, fda_settings.normalize_psr);
+    forces.write_total_forces(result_file, x, fda_settings.normalize_psr);
 }
 
 template <class Base>
 void FDABase<Base>::write_compat_header(int nsteps)
 {
-    if (!PF_or_PS_mode() or !compatibility_mode()) return;
+    if (!PF_or_PS_mode() or !compatibility_mode() or !fda_settings.master_rank) return;
+    if (writer) writer->wait();
 
     result_file << "<begin_block>" << std::endl;
     result_file << "; Forcemat version " << FDASettings::compat_fm_version << std::endl;
@@ -162,6 +325,14 @@ void FDABase<Base>::write_compat_header(int nsteps)
     result_file << "<end_block>" << std::endl;
 }
 
+template <class Base>
+void FDABase<Base>::write_frame_index()
+{
+    if (!binary_format() or !fda_settings.master_rank) return;
+    if (writer) writer->wait();
+    write_binary_index(result_file, frame_offsets);
+}
+
 template <class Base>
 void FDABase<Base>::write_frame_scalar_compat(int nsteps)
 {
@@ -177,28 +348,39 @@ void FDABase<Base>::write_frame_scalar_compat(int nsteps)
 }
 
 template <class Base>
-void FDABase<Base>::write_frame_summed_compat(gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, int nsteps)
+void FDABase<Base>::write_frame_summed_compat(DistributedForces const& forces, gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, int nsteps)
 {
     if (result_type == ResultType::COMPAT_ASCII) {
         result_file << "<begin_block>" << std::endl;
         result_file << nsteps << std::endl;
-        distributed_forces.write_summed_compat_ascii(result_file, x, box);
+        forces.write_summed_compat_ascii(result_file, x, box);
         result_file << "<end_block>" << std::endl;
     } else {
         result_file.write(reinterpret_cast<const char *>(&nsteps), sizeof(nsteps));
-        distributed_forces.write_summed_compat_bin(result_file, x, box);
+        forces.write_summed_compat_bin(result_file, x, box);
     }
 }
 
 template <>
 void FDABase<Atom>::write_virial_sum()
 {
+    if (fda_settings.binary_result_file) {
+        std::vector<real> values(6 * virial_stress.size());
+        for (int i = 0; i != virial_stress.size(); ++i) {
+            real const* v = virial_stress[i];
+            for (int c = 0; c != 6; ++c) values[6 * i + c] = -v[c];
+        }
+        result_file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(real));
+        return;
+    }
+
     bool first = true;
-    for (auto const& v : virial_stress) {
+    for (int i = 0; i != virial_stress.size(); ++i) {
+        real const* v = virial_stress[i];
         if (!first) result_file << " ";
         else first = false;
-        result_file << -v(XX, XX) << " " << -v(YY, YY) << " " << -v(ZZ, ZZ) << " "
-                    << -v(XX, YY) << " " << -v(XX, ZZ) << " " << -v(YY, ZZ);
+        result_file << -v[VirialStress::xx] << " " << -v[VirialStress::yy] << " " << -v[VirialStress::zz] << " "
+                    << -v[VirialStress::xy] << " " << -v[VirialStress::xz] << " " << -v[VirialStress::yz];
     }
     result_file << std::endl;
 }
@@ -210,11 +392,18 @@ void FDABase<Residue>::write_virial_sum()
 template <>
 void FDABase<Atom>::write_virial_sum_von_mises()
 {
+    if (fda_settings.binary_result_file) {
+        std::vector<real> values(virial_stress.size());
+        for (int i = 0; i != virial_stress.size(); ++i) values[i] = tensor_to_vonmises(virial_stress[i]);
+        result_file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(real));
+        return;
+    }
+
     bool first = true;
-    for (auto const& v : virial_stress) {
+    for (int i = 0; i != virial_stress.size(); ++i) {
         if (!first) result_file << " ";
         else first = false;
-        result_file << tensor_to_vonmises(v);
+        result_file << tensor_to_vonmises(virial_stress[i]);
     }
     result_file << std::endl;
 }
@@ -226,7 +415,8 @@ void FDABase<Residue>::write_virial_sum_von_mises()
 template <class Base>
 void FDABase<Base>::write_frame_number(int nsteps)
 {
-	if (!fda_settings.binary_result_file) result_file << "frame " << nsteps << std::endl;
+	if (binary_format()) frame_offsets.push_back(static_cast<std::streamoff>(result_file.tellp()));
+	else if (!fda_settings.binary_result_file) result_file << "frame " << nsteps << std::endl;
 }
 
 /// template instantiation
@@ -9,9 +9,12 @@
 #define SRC_GROMACS_FDA_FDABASE_H_
 
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <vector>
+#include "AsyncWriter.h"
 #include "FDASettings.h"
 #include "DistributedForces.h"
 #include "gromacs/gpu_utils/hostallocator.h"
@@ -19,11 +22,12 @@
 #include "gromacs/utility/fatalerror.h"
 #include "OnePair.h"
 #include "ResultType.h"
-#include "Tensor.h"
 #include "Vector2Scalar.h"
+#include "VirialStress.h"
 
 /// Forwarding needed for friend declaration
 class FDA;
+struct t_commrec;
 
 namespace fda {
 
@@ -35,14 +39,41 @@ struct Atom
      : virial_stress(VS_mode ? syslen : 0)
     {}
 
+    /// Allocate the virial stress buffers of the OpenMP threads
+    void init_threads(int nthreads)
+    {
+        thread_virial_stress.assign(nthreads - 1, VirialStress(virial_stress.size()));
+    }
+
+    /// Virial stress buffer of the OpenMP thread, the master thread writes directly into virial_stress
+    VirialStress& get_virial_stress(int thread)
+    {
+        return thread == 0 ? virial_stress : thread_virial_stress[thread - 1];
+    }
+
+    /// Add the virial stress of the OpenMP threads to virial_stress and clear the thread buffers
+    void reduce_threads();
+
+    /// Add the virial stress of the other MPI ranks to the master rank and clear it on the other ranks
+    void reduce_ranks(const t_commrec* cr);
+
     /// Virial stress
-    std::vector<Tensor> virial_stress;
+    VirialStress virial_stress;
+
+    /// Virial stress of the OpenMP threads 1 to nthreads-1
+    std::vector<VirialStress> thread_virial_stress;
 };
 
 /// Type for residue-based forces
 struct Residue
 {
     Residue(bool, int) {}
+
+    void init_threads(int) {}
+
+    void reduce_threads() {}
+
+    void reduce_ranks(const t_commrec*) {}
 };
 
 /**
@@ -80,15 +111,41 @@ public:
                result_type == ResultType::VIRIAL_STRESS_VON_MISES;
     }
 
+    /// Pairwise forces are written in the seekable binary format of BinaryFormat.h
+    bool binary_format() const {
+        return fda_settings.binary_result_file and
+               (result_type == ResultType::PAIRWISE_FORCES_VECTOR or
+                result_type == ResultType::PAIRWISE_FORCES_SCALAR);
+    }
+
+    /// Allocate one distributed forces buffer for each of the nthreads OpenMP threads
+    void init_threads(int nthreads);
+
+    /// Distributed forces buffer of the calling OpenMP thread
+    DistributedForces& get_thread_distributed_forces();
+
+    /// Add the forces of all OpenMP threads to distributed_forces and clear the thread buffers
+    void reduce_threads();
+
+    /**
+     * Gather the forces of all domain decomposition ranks into distributed_forces of the master rank,
+     * the other ranks clear their buffers; must be called after reduce_threads
+     */
+    void reduce_ranks(const t_commrec* cr);
+
+    /**
+     * Write the distributed forces of the current frame; with async_write_frames the forces are
+     * handed over to the writer thread and distributed_forces is replaced by an empty buffer
+     */
     void write_frame(gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, int nsteps);
 
-    void write_frame_detailed(gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, bool print_vector, int nsteps);
+    void write_frame_detailed(DistributedForces const& forces, gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, bool print_vector, int nsteps);
 
-    void write_frame_summed(gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, bool print_vector, int nsteps);
+    void write_frame_summed(DistributedForces const& forces, gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, bool print_vector, int nsteps);
 
     void write_frame_scalar(int nsteps);
 
-    void write_total_forces(gmx::PaddedHostVector<gmx::RVec> const& x);
+    void write_total_forces(DistributedForces const& forces, gmx::PaddedHostVector<gmx::RVec> const& x);
 
     /**
      * Writes a header as in original PF implementation;
@@ -100,9 +157,12 @@ public:
      */
     void write_compat_header(int nsteps);
 
+    /// Write the frame offsets at the end of a binary file
+    void write_frame_index();
+
     void write_frame_scalar_compat(int nsteps);
 
-    void write_frame_summed_compat(gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, int nsteps);
+    void write_frame_summed_compat(DistributedForces const& forces, gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, int nsteps);
 
     /// The stress is the negative atom_vir value.
     void write_virial_sum();
@@ -114,16 +174,31 @@ private:
 
     friend class ::FDA;
 
+    /// Frame handed over to the writer thread
+    struct Frame
+    {
+        Frame(int syslen, FDASettings const& fda_settings, bool direct_punctual_stress)
+         : forces(syslen, fda_settings, direct_punctual_stress)
+        {}
+
+        DistributedForces forces;
+        gmx::PaddedHostVector<gmx::RVec> x;
+        matrix box;
+        int nsteps;
+    };
+
+    void write_frame(DistributedForces const& forces, gmx::PaddedHostVector<gmx::RVec> const& x, const matrix box, int nsteps);
+
     void write_frame_number(int nsteps);
 
-    /// Convert a tensor to von Mises scalar value
-    real tensor_to_vonmises(Tensor t) const
+    /// Convert a packed symmetric tensor to von Mises scalar value
+    real tensor_to_vonmises(real const* t) const
     {
-        real txy = t(XX, XX)-t(YY, YY);
-        real tyz = t(YY, YY)-t(ZZ, ZZ);
-        real tzx = t(ZZ, ZZ)-t(XX, XX);
+        real txy = t[VirialStress::xx]-t[VirialStress::yy];
+        real tyz = t[VirialStress::yy]-t[VirialStress::zz];
+        real tzx = t[VirialStress::zz]-t[VirialStress::xx];
         return std::sqrt(0.5 * (txy*txy + tyz*tyz + tzx*tzx
-                         + 6 * (t(XX, YY)*t(XX, YY) + t(XX, ZZ)*t(XX, ZZ) + t(YY, ZZ)*t(YY, ZZ))));
+                         + 6 * (t[VirialStress::xy]*t[VirialStress::xy] + t[VirialStress::xz]*t[VirialStress::xz] + t[VirialStress::yz]*t[VirialStress::yz])));
     }
 
     /// Result type
@@ -135,12 +210,31 @@ private:
     /// Distributed forces
     DistributedForces distributed_forces;
 
+    /// Distributed forces of the OpenMP threads 1 to nthreads-1,
+    /// the master thread writes directly into distributed_forces
+    std::vector<DistributedForces> thread_distributed_forces;
+
+    /// Number of OpenMP threads adding forces
+    int nthreads;
+
     /// Result file
     std::ofstream result_file;
 
     /// For atom/residue unrelated settings
     FDASettings fda_settings;
 
+    /// Frame buffers of the writer thread, used round-robin
+    std::vector<Frame> frames;
+
+    /// Number of frames handed over to the writer thread
+    size_t nb_written_frames;
+
+    /// File offsets of the written frames in binary format
+    std::vector<uint64_t> frame_offsets;
+
+    /// Writer thread, must be destroyed first to finish writing into result_file
+    std::unique_ptr<AsyncWriter> writer;
+
 };
 
 } // namespace fda
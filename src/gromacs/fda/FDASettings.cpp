@@ -22,7 +22,7 @@ const std::string FDASettings::compat_fm_version = "1.5";
 
 const int FDASettings::compat_new_entry = -280480;
 
-FDASettings::FDASettings(int nfile, const t_filenm fnm[], gmx_mtop_t *mtop, bool parallel_execution)
+FDASettings::FDASettings(int nfile, const t_filenm fnm[], gmx_mtop_t *mtop, bool master_rank)
  : atom_based_result_type(ResultType::NO),
    residue_based_result_type(ResultType::NO),
    one_pair(OnePair::DETAILED),
@@ -42,12 +42,11 @@ FDASettings::FDASettings(int nfile, const t_filenm fnm[], gmx_mtop_t *mtop, bool
    groups(nullptr),
    groupnames(nullptr),
    normalize_psr(false),
-   ignore_missing_potentials(false)
+   direct_punctual_stress(false),
+   ignore_missing_potentials(false),
+   restrict_pairlist(false),
+   master_rank(master_rank)
 {
-    /// Parallel execution not implemented yet
-    if (parallel_execution)
-        gmx_fatal(FARGS, "FDA parallel execution not implemented yet! Please start with '-nt 1' on the mdrun command line\n");
-
     // check for the pf configuration file (specified with -pfi option);
     // if it doesn't exist, return NULL to specify that no pf handling is done;
     // otherwise, check also for specification of the index file (-pfn)
@@ -248,9 +247,32 @@ FDASettings::FDASettings(int nfile, const t_filenm fnm[], gmx_mtop_t *mtop, bool
     normalize_psr = strcasecmp(get_estr(&inp, "normalize_punctual_stress_per_residue", "no"), "no");
     std::cout << "Normalize punctual stress per residue: " << normalize_psr << std::endl;
 
+    // Accumulate punctual stress directly per atom/residue
+    direct_punctual_stress = strcasecmp(get_estr(&inp, "direct_punctual_stress", "no"), "no");
+    std::cout << "Direct punctual stress: " << direct_punctual_stress << std::endl;
+    if (direct_punctual_stress and v2s != Vector2Scalar::NORM)
+        gmx_fatal(FARGS, "Direct punctual stress can only be used with vector2scalar = norm.\n");
+    if (direct_punctual_stress and residue_based_result_type == ResultType::PUNCTUAL_STRESS)
+        gmx_fatal(FARGS, "Direct punctual stress is not supported for residue-based punctual stress.\n");
+
     // Ignore missing potentials
     ignore_missing_potentials = strcasecmp(get_estr(&inp, "ignore_missing_potentials", "no"), "no");
     std::cout << "Ignore missing potentials: " << ignore_missing_potentials << std::endl;
+
+    // Restrict the nonbonded pair search to the FDA groups
+    restrict_pairlist = strcasecmp(get_estr(&inp, "restrict_pairlist", "no"), "no");
+    std::cout << "Restrict pairlist: " << restrict_pairlist << std::endl;
+
+    // Write frames in a background thread
+    async_write_frames = get_eint(&inp, "async_write_frames", 0, wi);
+    if (async_write_frames < 0)
+        gmx_fatal(FARGS, "Invalid value for async_write_frames: %d\n", async_write_frames);
+    std::cout << "Asynchronous write frames: " << async_write_frames << std::endl;
+
+    nstfda = get_eint(&inp, "nstfda", 0, wi);
+    if (nstfda < 0)
+        gmx_fatal(FARGS, "Invalid value for nstfda: %d\n", nstfda);
+    std::cout << "FDA step interval in MD runs: " << nstfda << std::endl;
 }
 
 std::vector<int> FDASettings::groupatoms2residues(std::vector<int> const& group_atoms) const
@@ -42,11 +42,18 @@ struct FDASettings
        index_group2(-1),
        groups(nullptr),
        groupnames(nullptr),
-	   threshold(1e-10)
+	   threshold(1e-10),
+       normalize_psr(false),
+       direct_punctual_stress(false),
+       ignore_missing_potentials(false),
+       restrict_pairlist(false),
+       async_write_frames(0),
+       nstfda(0),
+       master_rank(true)
     {}
 
-    /// Construction by input file
-    FDASettings(int nfile, const t_filenm fnm[], gmx_mtop_t *mtop, bool parallel_execution);
+    /// Construction by input file, only the master rank writes the result files
+    FDASettings(int nfile, const t_filenm fnm[], gmx_mtop_t *mtop, bool master_rank);
 
     /// Returns true if atom i is in fda groups
     bool atom_in_groups(int i) const {
@@ -58,6 +65,13 @@ struct FDASettings
         return ((sys_in_group1[i] and sys_in_group2[j]) or (sys_in_group1[j] and sys_in_group2[i]));
     }
 
+    /// Returns per atom bit 0 set if in group1 and bit 1 set if in group2
+    std::vector<unsigned char> get_atom_group_bits() const {
+        std::vector<unsigned char> bits(syslen_atoms);
+        for (int i = 0; i != syslen_atoms; ++i) bits[i] = (sys_in_group1[i] ? 1 : 0) | (sys_in_group2[i] ? 2 : 0);
+        return bits;
+    }
+
     /// Makes a list of residue numbers based on atom numbers of this group.
     /// This is slightly more complex than needed to allow the residue numbers to retain the ordering given to atoms.
     std::vector<int> groupatoms2residues(std::vector<int> const& group_atoms) const;
@@ -182,11 +196,31 @@ struct FDASettings
     /// Normalize punctual stress per residue (default: off)
     bool normalize_psr;
 
+    /// Accumulate the punctual stress per atom/residue when the forces are added instead of storing the summed
+    /// pair forces. Each contribution is added by its norm, so that the stress of a pair with several
+    /// contributions is the sum of their norms and not the norm of their sum (default: off).
+    bool direct_punctual_stress;
+
     /// If true unsupported potentials will be ignored.
     /// Be aware that the sum of distributed forces do not agree with the total forces.
     /// If false the rerun will be stopped if a unsupported potential is used.
     bool ignore_missing_potentials;
 
+    /// If true the nonbonded pair search only keeps cluster pairs with atoms of group1 and group2.
+    /// Only for reruns, the total forces and energies do not contain the skipped pairs.
+    bool restrict_pairlist;
+
+    /// Number of frames which can be written by a background thread while the next frames are computed.
+    /// Zero writes the frames synchronously.
+    int async_write_frames;
+
+    /// Number of steps between two FDA frames in a regular MD run. Zero switches FDA off in MD runs.
+    /// On all other steps the FDA bookkeeping in the force routines is skipped.
+    int nstfda;
+
+    /// With domain decomposition the forces of all ranks are gathered and written by the master rank only
+    bool master_rank;
+
 };
 
 } // namespace fda
@@ -0,0 +1,66 @@
+/*
+ * MappedFile.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include "gmxpre.h"
+
+#include "config.h"
+
+#include <fstream>
+#include "gromacs/utility/fatalerror.h"
+#include "MappedFile.h"
+
+#if !GMX_NATIVE_WINDOWS && defined(HAVE_UNISTD_H)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FDA_USE_MMAP 1
+#else
+#define FDA_USE_MMAP 0
+#endif
+
+namespace fda {
+
+MappedFile::MappedFile(std::string const& filename)
+ : begin(nullptr),
+   length(0)
+{
+    {
+        std::ifstream is(filename, std::ifstream::binary);
+        if (!is) gmx_fatal(FARGS, "Error opening file %s", filename.c_str());
+        is.seekg(0, is.end);
+        length = is.tellg();
+    }
+
+    if (length == 0) return;
+
+#if FDA_USE_MMAP
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) gmx_fatal(FARGS, "Error opening file %s", filename.c_str());
+    void* p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) gmx_fatal(FARGS, "Error mapping file %s", filename.c_str());
+    // Frames are read in order by the analysis tools
+    madvise(p, length, MADV_SEQUENTIAL);
+    begin = static_cast<char const*>(p);
+#else
+    std::ifstream is(filename, std::ifstream::binary);
+    buffer.resize(length);
+    is.read(buffer.data(), length);
+    if (!is) gmx_fatal(FARGS, "Error reading file %s", filename.c_str());
+    begin = buffer.data();
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#if FDA_USE_MMAP
+    if (begin) munmap(const_cast<char*>(begin), length);
+#endif
+}
+
+} // namespace fda
@@ -0,0 +1,54 @@
+/*
+ * MappedFile.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_MAPPEDFILE_H_
+#define SRC_GROMACS_FDA_MAPPEDFILE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fda {
+
+/**
+ * Read-only memory map of a complete file
+ *
+ * Without mmap support the file is read into memory instead.
+ */
+class MappedFile
+{
+public:
+
+    MappedFile(std::string const& filename);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator = (MappedFile const&) = delete;
+
+    /// Begin of the mapped file, nullptr for an empty file
+    char const* data() const { return begin; }
+
+    /// Size of the mapped file in bytes
+    uint64_t size() const { return length; }
+
+private:
+
+    /// Begin of the mapped file
+    char const* begin;
+
+    /// Size of the mapped file in bytes
+    uint64_t length;
+
+    /// Fallback without mmap: complete file in memory
+    std::vector<char> buffer;
+
+};
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_MAPPEDFILE_H_ */
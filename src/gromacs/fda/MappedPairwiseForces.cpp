@@ -0,0 +1,42 @@
+/*
+ * MappedPairwiseForces.cpp
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <fstream>
+#include "gromacs/utility/fatalerror.h"
+#include "MappedPairwiseForces.h"
+
+namespace fda {
+
+template <int N>
+MappedPairwiseForces<N>::MappedPairwiseForces(std::string const& filename)
+ : filename(filename),
+   file(filename)
+{
+    {
+        std::ifstream is(filename, std::ifstream::binary);
+        if (!is) gmx_fatal(FARGS, "Error opening file %s", filename.c_str());
+        header = read_binary_header(is);
+        if (header.force_size != N or header.entry_size != sizeof(Entry))
+            gmx_fatal(FARGS, "File %s contains entries with %u force components of %u bytes, but %d components of %zu bytes are expected.",
+                filename.c_str(), header.force_size, header.entry_size, N, sizeof(Entry));
+        frame_offsets = read_binary_frame_offsets(is, header);
+    }
+
+    // Check that the frames are within the file, the trailer could be corrupt
+    uint64_t length = file.size();
+    for (auto offset : frame_offsets) {
+        if (offset + sizeof(uint64_t) > length or
+            *reinterpret_cast<uint64_t const*>(file.data() + offset) > (length - offset - sizeof(uint64_t)) / sizeof(Entry))
+            gmx_fatal(FARGS, "Frame at offset %lu exceeds the size of file %s", static_cast<unsigned long>(offset), filename.c_str());
+    }
+}
+
+/// template instantiation
+template class MappedPairwiseForces<1>;
+template class MappedPairwiseForces<3>;
+
+} // namespace fda
@@ -0,0 +1,67 @@
+/*
+ * MappedPairwiseForces.h
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_MAPPEDPAIRWISEFORCES_H_
+#define SRC_GROMACS_FDA_MAPPEDPAIRWISEFORCES_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "gromacs/fda/BinaryFormat.h"
+#include "gromacs/fda/MappedFile.h"
+#include "gromacs/utility/arrayref.h"
+
+namespace fda {
+
+/**
+ * Read-only memory map of a pairwise force file in the seekable binary format
+ *
+ * The frames are returned as views of the fixed-size entries (i, j, force, type)
+ * directly in the mapped file, no data is copied or allocated. The views are valid
+ * as long as the MappedPairwiseForces object exists.
+ * N is the number of force components, 1 for scalar and 3 for vector forces.
+ */
+template <int N>
+class MappedPairwiseForces
+{
+public:
+
+    typedef BinaryEntry<N> Entry;
+
+    MappedPairwiseForces(std::string const& filename);
+
+    MappedPairwiseForces(MappedPairwiseForces const&) = delete;
+    MappedPairwiseForces& operator = (MappedPairwiseForces const&) = delete;
+
+    BinaryHeader const& get_header() const { return header; }
+
+    size_t get_number_of_frames() const { return frame_offsets.size(); }
+
+    /// Entries of a frame as view into the mapped file
+    gmx::ArrayRef<const Entry> get_frame(size_t frame) const
+    {
+        char const* begin = file.data() + frame_offsets[frame];
+        uint64_t nb_entries = *reinterpret_cast<uint64_t const*>(begin);
+        Entry const* entries = reinterpret_cast<Entry const*>(begin + sizeof(uint64_t));
+        return gmx::ArrayRef<const Entry>(entries, entries + nb_entries);
+    }
+
+private:
+
+    std::string filename;
+
+    BinaryHeader header;
+
+    std::vector<uint64_t> frame_offsets;
+
+    MappedFile file;
+
+};
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_MAPPEDPAIRWISEFORCES_H_ */
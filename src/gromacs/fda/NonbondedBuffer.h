@@ -0,0 +1,104 @@
+/*
+ * NonbondedBuffer.h
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_NONBONDEDBUFFER_H_
+#define SRC_GROMACS_FDA_NONBONDEDBUFFER_H_
+
+#include <vector>
+#include "FDASettings.h"
+#include "InteractionType.h"
+#include "gromacs/utility/real.h"
+
+namespace fda {
+
+/**
+ * Compact side buffer for the scalar pair forces of the nonbonded kernels
+ *
+ * The kernels store the scalar Coulomb and LJ forces of a cluster pair lane-wise
+ * and append the pairs whose atoms are in the FDA groups.
+ * The buffer is drained into DistributedForces by FDA::drain_nonbonded_buffer
+ * at the end of each kernel call, so that the kernel loop itself stays free of
+ * the DistributedForces lookups.
+ */
+class NonbondedBuffer
+{
+public:
+
+    NonbondedBuffer(FDASettings const& fda_settings)
+     : fda_settings(fda_settings)
+    {}
+
+    /**
+     * Append the interactions of an i-cluster with a j-cluster
+     *
+     * The arrays are stored lane-wise as in the kernels, pair (i, j) is found at i * unrollj + j.
+     * Only pairs with a non-zero cut-off mask are added, all pairs if within_cutoff is nullptr. The first nlj i-atoms have LJ interactions,
+     * if coulomb is false only LJ is added. Forces of absent interactions must be zero.
+     */
+    template <int unrolli, int unrollj>
+    void add_cluster_pair(int const* ai, int const* aj, int nlj, bool coulomb,
+        real const* within_cutoff, real const* fcoul, real const* flj,
+        real const* dx, real const* dy, real const* dz)
+    {
+        for (int i = 0; i != unrolli; ++i) {
+            if (ai[i] < 0) continue;
+            InteractionType type = coulomb ? (i < nlj ? InteractionType_COULOMB | InteractionType_LJ : InteractionType_COULOMB) : InteractionType_LJ;
+            for (int j = 0; j != unrollj; ++j) {
+                int p = i * unrollj + j;
+                if ((within_cutoff and within_cutoff[p] == 0) or aj[j] < 0) continue;
+                if (!fda_settings.atoms_in_groups(ai[i], aj[j])) continue;
+                this->i.push_back(ai[i]);
+                this->j.push_back(aj[j]);
+                this->type.push_back(type);
+                this->fcoul.push_back(fcoul[p]);
+                this->flj.push_back(flj[p]);
+                this->dx.push_back(dx[p]);
+                this->dy.push_back(dy[p]);
+                this->dz.push_back(dz[p]);
+            }
+        }
+    }
+
+    size_t size() const { return i.size(); }
+
+    void clear()
+    {
+        i.clear();
+        j.clear();
+        type.clear();
+        fcoul.clear();
+        flj.clear();
+        dx.clear();
+        dy.clear();
+        dz.clear();
+    }
+
+    /// Global atom indices
+    std::vector<int> i;
+    std::vector<int> j;
+
+    /// COULOMB, LJ or both
+    std::vector<InteractionType> type;
+
+    /// Scalar forces, to be multiplied with the distance vector
+    std::vector<real> fcoul;
+    std::vector<real> flj;
+
+    /// Distance vector
+    std::vector<real> dx;
+    std::vector<real> dy;
+    std::vector<real> dz;
+
+private:
+
+    FDASettings const& fda_settings;
+
+};
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_NONBONDEDBUFFER_H_ */
@@ -12,16 +12,24 @@
 #include <stdexcept>
 #include "gromacs/utility/fatalerror.h"
 #include "PairwiseForces.h"
+#include "ResultType.h"
 
 namespace fda {
 
 template <typename ForceType>
 PairwiseForces<ForceType>::PairwiseForces(std::string const& filename)
  : filename(filename),
-   is_binary(false)
+   is_binary(false),
+   is_indexed(false)
 {
-    std::ifstream file(filename);
+    std::ifstream file(filename, std::ifstream::binary);
     if (!file) gmx_fatal(FARGS, "Error opening file %s", filename.c_str());
+    if (is_binary_format(file)) {
+        is_binary = true;
+        is_indexed = true;
+        mapped = std::make_shared<const MappedPairwiseForces<BinaryForce<ForceType>::size>>(filename);
+        return;
+    }
     char first_character;
     file.read(&first_character, 1);
     if (first_character == 'b') is_binary = true;
@@ -31,25 +39,11 @@ template <typename ForceType>
 size_t PairwiseForces<ForceType>::get_number_of_frames() const
 {
     size_t number_of_frames = 0;
-    if (this->is_binary) {
-        std::ifstream is(filename, std::ifstream::binary);
-        if (!is) gmx_fatal(FARGS, "Error opening file %s", filename.c_str());
-
-        // get length of file:
-        is.seekg (0, is.end);
-        int length = is.tellg();
-        is.seekg (0, is.beg);
-
-        char first_character;
-        is.read(&first_character, 1);
-        if (first_character != 'b') gmx_fatal(FARGS, "Wrong file type in PairwiseForces<ForceType>::write");
-
-        for (;;)
-        {
-            get_pairwise_forces_binary(is);
-            ++number_of_frames;
-            if (is.tellg() == length) break;
-        }
+    if (this->is_indexed) {
+        number_of_frames = mapped->get_number_of_frames();
+    } else if (this->is_binary) {
+        // Only the headers of the rows are read
+        number_of_frames = get_frame_index().size();
     } else {
         std::ifstream file(filename);
         if (!file) gmx_fatal(FARGS, "Error opening file %s", filename.c_str());
@@ -72,13 +66,19 @@ template <typename ForceType>
 std::vector<std::vector<PairwiseForce<ForceType>>> PairwiseForces<ForceType>::get_all_pairwise_forces(bool sort) const
 {
     std::vector<std::vector<PairwiseForce<ForceType>>> all_pairwise_forces;
-    if (this->is_binary) {
+    if (this->is_indexed) {
+        for (size_t frame = 0; frame != mapped->get_number_of_frames(); ++frame) {
+            auto&& pairwise_forces = get_pairwise_forces_indexed(frame);
+            if (sort) this->sort(pairwise_forces);
+            all_pairwise_forces.push_back(pairwise_forces);
+        }
+    } else if (this->is_binary) {
         std::ifstream is(filename, std::ifstream::binary);
         if (!is) gmx_fatal(FARGS, "Error opening file %s", filename.c_str());
 
         // get length of file:
         is.seekg (0, is.end);
-        int length = is.tellg();
+        std::streamoff length = is.tellg();
         is.seekg (0, is.beg);
 
         char first_character;
@@ -127,13 +127,18 @@ template <typename ForceType>
 size_t PairwiseForces<ForceType>::get_max_index_second_column_first_frame() const
 {
     int max_index = 0;
-    if (this->is_binary) {
+    if (this->is_indexed) {
+        if (mapped->get_number_of_frames() != 0) {
+            for (auto&& e : mapped->get_frame(0))
+                if (e.j > max_index) max_index = e.j;
+        }
+    } else if (this->is_binary) {
         std::ifstream is(filename, std::ifstream::binary);
         if (!is) gmx_fatal(FARGS, "Error opening file %s", filename.c_str());
 
         // get length of file:
         is.seekg (0, is.end);
-        int length = is.tellg();
+        std::streamoff length = is.tellg();
         is.seekg (0, is.beg);
 
         char first_character;
@@ -176,13 +181,21 @@ template <>
 std::vector<double> PairwiseForces<Force<real>>::get_forcematrix_of_frame(int nbParticles, int frame) const
 {
     std::vector<double> forcematrix(nbParticles * nbParticles, 0.0);
-    if (this->is_binary) {
+    if (this->is_indexed) {
+        if (frame < 0 or static_cast<size_t>(frame) >= mapped->get_number_of_frames()) gmx_fatal(FARGS, "Frame not found.");
+        for (auto&& e : mapped->get_frame(frame)) {
+            if (e.i >= nbParticles or e.j >= nbParticles)
+                gmx_fatal(FARGS, "Index is larger than dimension.");
+            forcematrix[e.i*nbParticles + e.j] = e.force[0];
+            forcematrix[e.j*nbParticles + e.i] = e.force[0];
+        }
+    } else if (this->is_binary) {
         std::ifstream is(filename, std::ifstream::binary);
         if (!is) gmx_fatal(FARGS, "Error opening file %s", filename.c_str());
 
         // get length of file:
         is.seekg (0, is.end);
-        int length = is.tellg();
+        std::streamoff length = is.tellg();
         is.seekg (0, is.beg);
 
         char first_character;
@@ -246,6 +259,294 @@ std::vector<double> PairwiseForces<Force<real>>::get_forcematrix_of_frame(int nb
     return forcematrix;
 }
 
+template <typename ForceType>
+PairwiseForces<ForceType>::FrameReader::FrameReader(PairwiseForces const& pairwise_forces)
+ : pairwise_forces(pairwise_forces),
+   length(0),
+   has_next_frame(false),
+   frame(0)
+{
+    if (pairwise_forces.is_indexed) return;
+
+    std::string const& filename = pairwise_forces.filename;
+    is.open(filename, std::ifstream::binary);
+    if (!is) gmx_fatal(FARGS, "Error opening file %s", filename.c_str());
+
+    if (pairwise_forces.is_binary) {
+        is.seekg (0, is.end);
+        length = is.tellg();
+        is.seekg (0, is.beg);
+
+        char first_character;
+        is.read(&first_character, 1);
+        if (first_character != 'b') gmx_fatal(FARGS, "Wrong file type in PairwiseForces<ForceType>::FrameReader");
+    } else {
+        std::string token;
+        is >> token;
+        if (token != "pairwise_forces_scalar" and token != "pairwise_forces_vector") gmx_fatal(FARGS, "Wrong file type in PairwiseForces<ForceType>::FrameReader");
+        is >> token;
+        has_next_frame = (token == "frame");
+        is >> token;
+    }
+}
+
+template <typename ForceType>
+bool PairwiseForces<ForceType>::FrameReader::next(std::vector<PairwiseForce<ForceType>>& frame_pairwise_forces)
+{
+    frame_pairwise_forces.clear();
+    if (pairwise_forces.is_indexed) {
+        if (frame == pairwise_forces.mapped->get_number_of_frames()) return false;
+        for (auto&& e : pairwise_forces.mapped->get_frame(frame))
+            frame_pairwise_forces.push_back(PairwiseForce<ForceType>(e.i, e.j, BinaryForce<ForceType>::get(e)));
+    } else if (pairwise_forces.is_binary) {
+        if (is.tellg() == length) return false;
+        frame_pairwise_forces = pairwise_forces.get_pairwise_forces_binary(is);
+    } else {
+        if (!has_next_frame) return false;
+        int i, j;
+        ForceType force;
+        std::string token;
+        has_next_frame = false;
+        while (is >> token)
+        {
+            if (token == "frame") {
+                is >> token;
+                has_next_frame = true;
+                break;
+            }
+            i = std::stoi(token);
+            is >> j >> force;
+            frame_pairwise_forces.push_back(PairwiseForce<ForceType>(i, j, force));
+        }
+    }
+    ++frame;
+    return true;
+}
+
+template <typename ForceType>
+void PairwiseForces<ForceType>::FrameReader::seek(size_t frame, FrameIndex const& frame_index)
+{
+    this->frame = frame;
+    if (pairwise_forces.is_indexed) {
+        if (frame > pairwise_forces.mapped->get_number_of_frames()) gmx_fatal(FARGS, "Frame not found.");
+        return;
+    }
+    if (frame > frame_index.size()) gmx_fatal(FARGS, "Frame not found.");
+    is.clear();
+    if (pairwise_forces.is_binary) {
+        is.seekg(frame == frame_index.size() ? length : frame_index[frame]);
+    } else {
+        has_next_frame = frame != frame_index.size();
+        if (has_next_frame) is.seekg(frame_index[frame]);
+    }
+}
+
+template <typename ForceType>
+bool PairwiseForces<ForceType>::FrameReader::skip()
+{
+    if (pairwise_forces.is_indexed) {
+        if (frame == pairwise_forces.mapped->get_number_of_frames()) return false;
+        ++frame;
+        return true;
+    }
+    return next(buffer);
+}
+
+template <>
+bool PairwiseForces<Force<real>>::FrameReader::next_forcematrix(std::vector<double>& forcematrix, int nbParticles)
+{
+    forcematrix.assign(nbParticles * nbParticles, 0.0);
+    if (pairwise_forces.is_indexed) {
+        if (frame == pairwise_forces.mapped->get_number_of_frames()) return false;
+        for (auto&& e : pairwise_forces.mapped->get_frame(frame)) {
+            if (e.i >= nbParticles or e.j >= nbParticles)
+                gmx_fatal(FARGS, "Index is larger than dimension.");
+            forcematrix[e.i*nbParticles + e.j] = e.force[0];
+            forcematrix[e.j*nbParticles + e.i] = e.force[0];
+        }
+        ++frame;
+        return true;
+    }
+    if (!next(buffer)) return false;
+    for (auto&& pf : buffer) {
+        if (pf.i >= nbParticles or pf.j >= nbParticles)
+            gmx_fatal(FARGS, "Index is larger than dimension.");
+        forcematrix[pf.i*nbParticles + pf.j] = pf.force.force;
+        forcematrix[pf.j*nbParticles + pf.i] = pf.force.force;
+    }
+    return true;
+}
+
+template <>
+bool PairwiseForces<Force<Vector>>::FrameReader::next_forcematrix(std::vector<double>& /*forcematrix*/, int /*nbParticles*/)
+{
+    gmx_fatal(FARGS, "Force matrix is only available for scalar forces.");
+}
+
+template <>
+bool PairwiseForces<Force<real>>::FrameReader::next_forcematrix(SparseForceMatrix& forcematrix, int nbParticles)
+{
+    forcematrix.reset(nbParticles);
+    if (pairwise_forces.is_indexed) {
+        if (frame == pairwise_forces.mapped->get_number_of_frames()) return false;
+        for (auto&& e : pairwise_forces.mapped->get_frame(frame)) forcematrix.set_symmetric(e.i, e.j, e.force[0]);
+        ++frame;
+    } else {
+        if (!next(buffer)) return false;
+        for (auto&& pf : buffer) forcematrix.set_symmetric(pf.i, pf.j, pf.force.force);
+    }
+    forcematrix.compress();
+    return true;
+}
+
+template <>
+bool PairwiseForces<Force<Vector>>::FrameReader::next_forcematrix(SparseForceMatrix& /*forcematrix*/, int /*nbParticles*/)
+{
+    gmx_fatal(FARGS, "Force matrix is only available for scalar forces.");
+}
+
+template <>
+bool PairwiseForces<Force<real>>::FrameReader::next_pairs(int nbParticles)
+{
+    pairs.clear();
+    auto add = [this, nbParticles](int i, int j, real force) {
+        if (i < 0 or j < 0 or i >= nbParticles or j >= nbParticles)
+            gmx_fatal(FARGS, "Index is larger than dimension.");
+        if (i > j) std::swap(i, j);
+        pairs.push_back({i, j, force});
+    };
+    if (pairwise_forces.is_indexed) {
+        if (frame == pairwise_forces.mapped->get_number_of_frames()) return false;
+        for (auto&& e : pairwise_forces.mapped->get_frame(frame)) add(e.i, e.j, e.force[0]);
+        ++frame;
+    } else {
+        if (!next(buffer)) return false;
+        for (auto&& pf : buffer) add(pf.i, pf.j, pf.force.force);
+    }
+
+    // Pairs written by FDA are already sorted, the order of identical pairs must be kept
+    auto less = [](Pair const& p1, Pair const& p2) { return p1.i < p2.i or (p1.i == p2.i and p1.j < p2.j); };
+    if (!std::is_sorted(pairs.begin(), pairs.end(), less)) std::stable_sort(pairs.begin(), pairs.end(), less);
+
+    // The last force of a pair wins, as in SparseForceMatrix::set_symmetric
+    size_t m = 0;
+    for (auto const& pair : pairs) {
+        if (m and pairs[m - 1].i == pair.i and pairs[m - 1].j == pair.j) pairs[m - 1] = pair;
+        else pairs[m++] = pair;
+    }
+    pairs.resize(m);
+    return true;
+}
+
+template <>
+bool PairwiseForces<Force<Vector>>::FrameReader::next_pairs(int /*nbParticles*/)
+{
+    gmx_fatal(FARGS, "Force matrix is only available for scalar forces.");
+}
+
+template <>
+bool PairwiseForces<Force<real>>::FrameReader::next_forcematrix_diff(FrameReader& other, SparseForceMatrix& forcematrix, int nbParticles)
+{
+    if (!next_pairs(nbParticles)) return false;
+    if (!other.next_pairs(nbParticles)) gmx_fatal(FARGS, "Frame not found.");
+
+    forcematrix.reset(nbParticles);
+    auto p1 = pairs.cbegin(), end1 = pairs.cend();
+    auto p2 = other.pairs.cbegin(), end2 = other.pairs.cend();
+    while (p1 != end1 or p2 != end2) {
+        int i, j;
+        double value;
+        if (p2 == end2 or (p1 != end1 and (p1->i < p2->i or (p1->i == p2->i and p1->j < p2->j)))) {
+            i = p1->i;
+            j = p1->j;
+            value = p1->force;
+            ++p1;
+        } else if (p1 == end1 or p2->i < p1->i or (p2->i == p1->i and p2->j < p1->j)) {
+            i = p2->i;
+            j = p2->j;
+            value = -static_cast<double>(p2->force);
+            ++p2;
+        } else {
+            i = p1->i;
+            j = p1->j;
+            value = static_cast<double>(p1->force) - p2->force;
+            ++p1;
+            ++p2;
+        }
+        if (value != 0.0) forcematrix.set_symmetric(i, j, value);
+    }
+    forcematrix.compress();
+    return true;
+}
+
+template <>
+bool PairwiseForces<Force<Vector>>::FrameReader::next_forcematrix_diff(FrameReader& /*other*/, SparseForceMatrix& /*forcematrix*/, int /*nbParticles*/)
+{
+    gmx_fatal(FARGS, "Force matrix is only available for scalar forces.");
+}
+
+template <typename ForceType>
+SparseForceMatrix PairwiseForces<ForceType>::get_sparse_forcematrix_of_frame(int nbParticles, int frame) const
+{
+    if (frame < 0) gmx_fatal(FARGS, "Frame not found.");
+    FrameReader reader(*this);
+    for (int i = 0; i != frame; ++i) {
+        if (!reader.skip()) gmx_fatal(FARGS, "Frame not found.");
+    }
+    SparseForceMatrix forcematrix;
+    if (!reader.next_forcematrix(forcematrix, nbParticles)) gmx_fatal(FARGS, "Frame not found.");
+    return forcematrix;
+}
+
+template <typename ForceType>
+SparseForceMatrix PairwiseForces<ForceType>::get_sparse_forcematrix_diff_of_frame(PairwiseForces const& other, int nbParticles, int frame) const
+{
+    if (frame < 0) gmx_fatal(FARGS, "Frame not found.");
+    FrameReader reader(*this), reader_other(other);
+    for (int i = 0; i != frame; ++i) {
+        if (!reader.skip() or !reader_other.skip()) gmx_fatal(FARGS, "Frame not found.");
+    }
+    SparseForceMatrix forcematrix;
+    if (!reader.next_forcematrix_diff(reader_other, forcematrix, nbParticles)) gmx_fatal(FARGS, "Frame not found.");
+    return forcematrix;
+}
+
+template <typename ForceType>
+typename PairwiseForces<ForceType>::FrameIndex PairwiseForces<ForceType>::get_frame_index() const
+{
+    FrameIndex frame_index;
+    if (this->is_indexed) return frame_index;
+
+    std::ifstream is(filename, std::ifstream::binary);
+    if (!is) gmx_fatal(FARGS, "Error opening file %s", filename.c_str());
+
+    if (this->is_binary) {
+        is.seekg(0, is.end);
+        std::streamoff length = is.tellg();
+        is.seekg(1, is.beg);
+
+        // Only the headers of the rows are read, the interactions are skipped
+        int i, nb_interaction, nb_interactions_of_i;
+        while (is.tellg() < length) {
+            frame_index.push_back(is.tellg());
+            is.read(reinterpret_cast<char*>(&nb_interaction), sizeof(uint));
+            for (int n = 0; n != nb_interaction; n += nb_interactions_of_i) {
+                is.read(reinterpret_cast<char*>(&i), sizeof(uint));
+                is.read(reinterpret_cast<char*>(&nb_interactions_of_i), sizeof(uint));
+                is.seekg(nb_interactions_of_i * (2 * sizeof(uint) + sizeof(real)), is.cur);
+            }
+            if (!is) gmx_fatal(FARGS, "Error reading file %s", filename.c_str());
+        }
+    } else {
+        // The frame starts behind its header line
+        std::string line;
+        while (getline(is, line)) {
+            if (line.find("frame") != std::string::npos) frame_index.push_back(is.tellg());
+        }
+    }
+    return frame_index;
+}
+
 template <typename ForceType>
 std::vector<double> PairwiseForces<ForceType>::get_averaged_forcematrix(int nbParticles) const
 {
@@ -302,13 +603,21 @@ std::vector<double> PairwiseForces<ForceType>::get_averaged_forcematrix(int nbPa
 template <typename ForceType>
 void PairwiseForces<ForceType>::write(std::string const& out_filename, bool out_binary) const
 {
-    if (this->is_binary == true and out_binary == false) {
+    if (this->is_indexed == true and out_binary == false) {
+        std::ofstream os(out_filename);
+        if (!os) gmx_fatal(FARGS, "Error opening file %s", out_filename.c_str());
+
+        os << static_cast<ResultType>(mapped->get_header().result_type) << "\n";
+        for (size_t frame = 0; frame != mapped->get_number_of_frames(); ++frame) {
+            write_pairwise_forces(os, get_pairwise_forces_indexed(frame), frame);
+        }
+    } else if (this->is_binary == true and out_binary == false) {
         std::ifstream is(filename, std::ifstream::binary);
         if (!is) gmx_fatal(FARGS, "Error opening file %s", filename.c_str());
 
         // get length of file:
         is.seekg (0, is.end);
-        int length = is.tellg();
+        std::streamoff length = is.tellg();
         is.seekg (0, is.beg);
 
         std::ofstream os(out_filename);
@@ -335,20 +644,28 @@ void PairwiseForces<ForceType>::write(std::string const& out_filename, bool out_
         std::ofstream os(out_filename, std::ifstream::binary);
         if (!os) gmx_fatal(FARGS, "Error opening file %s", filename.c_str());
 
+        ResultType result_type;
+        is >> result_type;
+        if (result_type != ResultType::PAIRWISE_FORCES_SCALAR and result_type != ResultType::PAIRWISE_FORCES_VECTOR)
+            gmx_fatal(FARGS, "Wrong file type in PairwiseForces<ForceType>::write");
         std::string token;
-        is >> token;
-        if (token != "pairwise_forces_scalar") gmx_fatal(FARGS, "Wrong file type in PairwiseForces<ForceType>::write");
         is >> token >> token;
 
-        char b = 'b';
-        os.write(&b, 1);
+        BinaryHeader out_header;
+        out_header.result_type = static_cast<int32_t>(result_type);
+        out_header.force_size = BinaryForce<ForceType>::size;
+        out_header.entry_size = sizeof(BinaryEntry<BinaryForce<ForceType>::size>);
+        write_binary_header(os, out_header);
 
+        std::vector<uint64_t> out_frame_offsets;
         for (;;)
         {
             auto&& pairwise_forces = get_pairwise_forces(is);
             if (pairwise_forces.empty()) break;
+            out_frame_offsets.push_back(static_cast<std::streamoff>(os.tellp()));
             write_pairwise_forces_binary(os, pairwise_forces);
         }
+        write_binary_index(os, out_frame_offsets);
     } else {
         gmx_fatal(FARGS, "Wrong binary mode in PairwiseForces<ForceType>::write");
     }
@@ -401,6 +718,16 @@ std::vector<PairwiseForce<ForceType>> PairwiseForces<ForceType>::get_pairwise_fo
     return pairwise_forces;
 }
 
+template <typename ForceType>
+std::vector<PairwiseForce<ForceType>> PairwiseForces<ForceType>::get_pairwise_forces_indexed(size_t frame) const
+{
+    auto entries = mapped->get_frame(frame);
+    std::vector<PairwiseForce<ForceType>> pairwise_forces;
+    pairwise_forces.reserve(entries.size());
+    for (auto&& e : entries) pairwise_forces.push_back(PairwiseForce<ForceType>(e.i, e.j, BinaryForce<ForceType>::get(e)));
+    return pairwise_forces;
+}
+
 template <typename ForceType>
 void PairwiseForces<ForceType>::write_pairwise_forces(std::ofstream& os, std::vector<PairwiseForce<ForceType>> const& pairwise_forces, int frame) const
 {
@@ -414,25 +741,10 @@ void PairwiseForces<ForceType>::write_pairwise_forces(std::ofstream& os, std::ve
 template <typename ForceType>
 void PairwiseForces<ForceType>::write_pairwise_forces_binary(std::ofstream& os, std::vector<PairwiseForce<ForceType>> const& pairwise_forces) const
 {
-    uint nb_interaction = pairwise_forces.size();
-    os.write(reinterpret_cast<char*>(&nb_interaction), sizeof(uint));
-    auto&& iter_end = pairwise_forces.end();
-    for (auto&& iter = pairwise_forces.begin(); iter != iter_end; ++iter) {
-        os.write(reinterpret_cast<const char*>(&(iter->i)), sizeof(uint));
-        uint nb_interactions_of_i = 1;
-        auto&& iter2 = iter + 1;
-        for (; iter2 != iter_end; ++iter2) {
-            if (iter2->i != iter->i) break;
-            ++nb_interactions_of_i;
-        }
-        os.write(reinterpret_cast<char*>(&nb_interactions_of_i), sizeof(uint));
-        for (; iter != iter2; ++iter) {
-            os.write(reinterpret_cast<const char*>(&iter->j), sizeof(uint));
-            os.write(reinterpret_cast<const char*>(&iter->force.force), sizeof(real));
-            os.write(reinterpret_cast<const char*>(&iter->force.type), sizeof(uint));
-        }
-        --iter;
-    }
+    std::vector<BinaryEntry<BinaryForce<ForceType>::size>> entries;
+    entries.reserve(pairwise_forces.size());
+    for (auto&& pf : pairwise_forces) entries.push_back(BinaryForce<ForceType>::put(pf.i, pf.j, pf.force));
+    write_binary_frame(os, entries);
 }
 
 /// template instantiation
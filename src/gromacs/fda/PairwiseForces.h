@@ -8,9 +8,15 @@
 #ifndef SRC_GROMACS_FDA_PAIRWISEFORCES_H_
 #define SRC_GROMACS_FDA_PAIRWISEFORCES_H_
 
+#include <cstdint>
+#include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
+#include "gromacs/fda/BinaryFormat.h"
 #include "gromacs/fda/Force.h"
+#include "gromacs/fda/MappedPairwiseForces.h"
+#include "gromacs/fda/SparseForceMatrix.h"
 #include "gromacs/fda/Vector.h"
 #include "gromacs/utility/real.h"
 
@@ -53,6 +59,38 @@ std::ostream& operator << (std::ostream& os, std::vector<PairwiseForce<ForceType
     return os;
 }
 
+/// Conversion between ForceType and the entries of the binary format
+template <typename ForceType>
+struct BinaryForce;
+
+template <>
+struct BinaryForce<Force<real>>
+{
+    static constexpr int size = 1;
+
+    static Force<real> get(BinaryEntry<1> const& e) { return Force<real>(e.force[0], e.type); }
+
+    static BinaryEntry<1> put(int i, int j, Force<real> const& f) { return {i, j, {f.force}, f.type}; }
+};
+
+template <>
+struct BinaryForce<Force<Vector>>
+{
+    static constexpr int size = 3;
+
+    static Force<Vector> get(BinaryEntry<3> const& e)
+    {
+        Vector force;
+        for (int d = 0; d != 3; ++d) force[d] = e.force[d];
+        return Force<Vector>(force, e.type);
+    }
+
+    static BinaryEntry<3> put(int i, int j, Force<Vector> const& f)
+    {
+        return {i, j, {f.force[0], f.force[1], f.force[2]}, f.type};
+    }
+};
+
 /**
  * Read pairwise forces from file into arrays and compare.
  */
@@ -101,6 +139,91 @@ struct PairwiseForces
     /// atom/residues. Can read a single frame given by the argument frame.
     std::vector<double> get_forcematrix_of_frame(int nbParticles, int frame) const;
 
+    /// Same as get_forcematrix_of_frame, but only the non-zero elements are stored.
+    SparseForceMatrix get_sparse_forcematrix_of_frame(int nbParticles, int frame) const;
+
+    /// Difference to the same frame of other, see FrameReader::next_forcematrix_diff
+    SparseForceMatrix get_sparse_forcematrix_diff_of_frame(PairwiseForces const& other, int nbParticles, int frame) const;
+
+    /// Stream positions of the frames in the text and legacy binary format
+    typedef std::vector<std::streamoff> FrameIndex;
+
+    /// Scan the file once for the positions of all frames. The index is read-only
+    /// and can be shared by readers in different threads. It is empty for the
+    /// seekable binary format, which contains its own index.
+    FrameIndex get_frame_index() const;
+
+    /**
+     * Forward reader over the frames of the file
+     *
+     * Each frame is parsed only once, so that walking through all frames is linear in the file size.
+     */
+    class FrameReader
+    {
+    public:
+
+        FrameReader(PairwiseForces const& pairwise_forces);
+
+        /// Read the next frame, returns false if all frames were read
+        bool next(std::vector<PairwiseForce<ForceType>>& frame_pairwise_forces);
+
+        /// Skip the next frame, returns false if all frames were read
+        bool skip();
+
+        /// Read the next frame as symmetric force matrix of a given number of
+        /// atom/residues, only for scalar forces. Returns false if all frames were read.
+        bool next_forcematrix(std::vector<double>& forcematrix, int nbParticles);
+
+        /// Same as above for the sparse force matrix
+        bool next_forcematrix(SparseForceMatrix& forcematrix, int nbParticles);
+
+        /// Read the next frame of this reader and of other and store the difference as sparse
+        /// force matrix. Both pair lists are merged by (i, j) without building a matrix for each
+        /// file, only the current frame is held in memory. Returns false if all frames were read.
+        bool next_forcematrix_diff(FrameReader& other, SparseForceMatrix& forcematrix, int nbParticles);
+
+        /// Continue with a given frame, frame_index must be from PairwiseForces::get_frame_index
+        void seek(size_t frame, FrameIndex const& frame_index);
+
+        /// Number of frames read or skipped
+        size_t get_frame() const { return frame; }
+
+    private:
+
+        PairwiseForces const& pairwise_forces;
+
+        /// Stream for the text and legacy binary format
+        std::ifstream is;
+
+        /// Length of the legacy binary file
+        std::streamoff length;
+
+        /// A further frame header was found in the text format
+        bool has_next_frame;
+
+        size_t frame;
+
+        /// Buffer for next_forcematrix
+        std::vector<PairwiseForce<ForceType>> buffer;
+
+        /// Scalar force of the pair (i, j) with i <= j
+        struct Pair
+        {
+            int i;
+            int j;
+            real force;
+        };
+
+        /// Pairs of the current frame sorted by (i, j) for next_forcematrix_diff
+        std::vector<Pair> pairs;
+
+        /// Read the next frame into pairs, returns false if all frames were read
+        bool next_pairs(int nbParticles);
+    };
+
+    /// Returns a reader starting at the first frame
+    FrameReader get_frame_reader() const { return FrameReader(*this); }
+
     /// Parse a file in the scalar format which contains a given number of
     /// atom/residues. Returns average over all frames.
     std::vector<double> get_averaged_forcematrix(int nbParticles) const;
@@ -111,6 +234,12 @@ struct PairwiseForces
     /// Returns true if the format is binary
     bool get_is_binary() const { return is_binary; }
 
+    /// Returns true if the format is the seekable binary format with frame index
+    bool get_is_indexed() const { return is_indexed; }
+
+    /// Memory map of the seekable binary format, nullptr for other formats
+    std::shared_ptr<const MappedPairwiseForces<BinaryForce<ForceType>::size>> get_mapped() const { return mapped; }
+
 private:
 
     /// Sorting the pairwise forces by i, j, and type
@@ -119,6 +248,9 @@ private:
     std::vector<PairwiseForce<ForceType>> get_pairwise_forces(std::ifstream& is) const;
     std::vector<PairwiseForce<ForceType>> get_pairwise_forces_binary(std::ifstream& is) const;
 
+    /// Copy a single frame of the seekable binary format
+    std::vector<PairwiseForce<ForceType>> get_pairwise_forces_indexed(size_t frame) const;
+
     void write_pairwise_forces(std::ofstream& os, std::vector<PairwiseForce<ForceType>> const& pairwise_forces, int frame) const;
     void write_pairwise_forces_binary(std::ofstream& os, std::vector<PairwiseForce<ForceType>> const& pairwise_forces) const;
 
@@ -141,6 +273,11 @@ private:
 
     bool is_binary;
 
+    bool is_indexed;
+
+    /// Memory map of the seekable binary format, shared by copies
+    std::shared_ptr<const MappedPairwiseForces<BinaryForce<ForceType>::size>> mapped;
+
 };
 
 } // namespace fda
@@ -0,0 +1,61 @@
+/*
+ * ResidueCOM.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <algorithm>
+#include "ResidueCOM.h"
+
+namespace fda {
+
+ResidueCOM::ResidueCOM(FDASettings const& fda_settings, gmx_mtop_t const& mtop)
+ : residue_masses(fda_settings.syslen_residues, 0.0),
+   com(fda_settings.syslen_residues)
+{
+    int atom_global_index = 0;
+    for (auto const& mb : mtop.molblock) {
+        t_atoms const& mol_atoms = mtop.moltype[mb.type].atoms;
+        for (int mol_index = 0; mol_index < mb.nmol; ++mol_index) {
+            for (int atom_index = 0; atom_index < mol_atoms.nr; ++atom_index, ++atom_global_index) {
+                if (!fda_settings.atom_in_groups(atom_global_index)) continue;
+                real mass = mol_atoms.atom[atom_index].m;
+                int residue = fda_settings.atom_2_residue[atom_global_index];
+                atoms.push_back(atom_global_index);
+                residues.push_back(residue);
+                masses.push_back(mass);
+                residue_masses[residue] += mass;
+            }
+        }
+    }
+}
+
+gmx::PaddedHostVector<gmx::RVec> const& ResidueCOM::compute(gmx::PaddedHostVector<gmx::RVec> const& x)
+{
+    std::fill(com.begin(), com.end(), gmx::RVec(0.0, 0.0, 0.0));
+
+    int const* atom = atoms.data();
+    int const* residue = residues.data();
+    real const* mass = masses.data();
+    for (size_t a = 0; a != atoms.size(); ++a) {
+        gmx::RVec const& xa = x[atom[a]];
+        gmx::RVec& com_r = com[residue[a]];
+        com_r[XX] += mass[a] * xa[XX];
+        com_r[YY] += mass[a] * xa[YY];
+        com_r[ZZ] += mass[a] * xa[ZZ];
+    }
+
+    // Residues without group atoms stay at the origin
+    for (size_t r = 0; r != residue_masses.size(); ++r) {
+        if (residue_masses[r] != 0.0) {
+            com[r][XX] /= residue_masses[r];
+            com[r][YY] /= residue_masses[r];
+            com[r][ZZ] /= residue_masses[r];
+        }
+    }
+
+    return com;
+}
+
+} // namespace fda
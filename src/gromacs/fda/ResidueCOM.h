@@ -0,0 +1,59 @@
+/*
+ * ResidueCOM.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_RESIDUECOM_H_
+#define SRC_GROMACS_FDA_RESIDUECOM_H_
+
+#include <vector>
+#include "FDASettings.h"
+#include "gromacs/gpu_utils/hostallocator.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/topology/topology.h"
+#include "gromacs/utility/real.h"
+
+namespace fda {
+
+/**
+ * Center of mass of the residues for residue-based forces
+ *
+ * Only the atoms of group1 and group2 are considered, such that the COM might not be
+ * the COM of the whole residue but the COM of the atoms of the residue which are
+ * interesting for FDA. The group atoms, their residues and masses are collected once
+ * from the topology, so that a frame only loops over the group atoms.
+ */
+class ResidueCOM
+{
+public:
+
+    ResidueCOM(FDASettings const& fda_settings, gmx_mtop_t const& mtop);
+
+    /// Returns the COM of all residues, residues without group atoms are at the origin.
+    /// The returned buffer is reused by the next call.
+    gmx::PaddedHostVector<gmx::RVec> const& compute(gmx::PaddedHostVector<gmx::RVec> const& x);
+
+private:
+
+    /// Global indices of the group atoms
+    std::vector<int> atoms;
+
+    /// Residue of the group atoms
+    std::vector<int> residues;
+
+    /// Mass of the group atoms
+    std::vector<real> masses;
+
+    /// Sum of the masses of the group atoms per residue
+    std::vector<real> residue_masses;
+
+    /// COM of all residues
+    gmx::PaddedHostVector<gmx::RVec> com;
+
+};
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_RESIDUECOM_H_ */
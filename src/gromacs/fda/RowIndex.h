@@ -0,0 +1,100 @@
+/*
+ * RowIndex.h
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_ROWINDEX_H_
+#define SRC_GROMACS_FDA_ROWINDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fda {
+
+/**
+ * Lookup of the position of the second atom j within one row of DistributedForces
+ *
+ * The row itself (the vector of j indices in insertion order) is owned by DistributedForces,
+ * this class only stores an open-addressing hash table with linear probing on top of it,
+ * mapping j to its position in the row. Short rows are searched linearly and the
+ * table is only built when the row exceeds linear_search_limit entries.
+ * The insertion order of the row and therefore the output order is not changed.
+ */
+class RowIndex
+{
+public:
+
+    /// Returns the position of j in row or -1 if j is not in row
+    int find(std::vector<int> const& row, int j) const
+    {
+        if (table.empty()) {
+            for (size_t p = 0; p != row.size(); ++p) {
+                if (row[p] == j) return static_cast<int>(p);
+            }
+            return -1;
+        }
+        for (uint32_t s = hash(j);; s = (s + 1) & mask()) {
+            int p = table[s];
+            if (p == empty) return -1;
+            if (row[p] == j) return p;
+        }
+    }
+
+    /// Must be called after the last element of row was appended
+    void inserted(std::vector<int> const& row)
+    {
+        if (row.size() <= linear_search_limit) return;
+        // Keep the load factor below 1/2
+        if (2 * row.size() > table.size()) rebuild(row);
+        else insert(row, row.size() - 1);
+    }
+
+    /// Drop the hash table, the row will be searched linearly until it grows again
+    void clear()
+    {
+        table.clear();
+        log2_size = 0;
+    }
+
+private:
+
+    /// Below this number of entries a linear search is faster than hashing
+    static constexpr size_t linear_search_limit = 16;
+
+    /// Marker of an unused slot
+    static constexpr int empty = -1;
+
+    uint32_t mask() const { return table.size() - 1; }
+
+    /// Fibonacci hashing, the upper bits are the best mixed ones
+    uint32_t hash(int j) const { return (static_cast<uint32_t>(j) * 2654435769u) >> (32 - log2_size); }
+
+    void insert(std::vector<int> const& row, int p)
+    {
+        uint32_t s = hash(row[p]);
+        while (table[s] != empty) s = (s + 1) & mask();
+        table[s] = p;
+    }
+
+    void rebuild(std::vector<int> const& row)
+    {
+        log2_size = 1;
+        while ((1u << log2_size) < 4 * row.size()) ++log2_size;
+        table.assign(1u << log2_size, empty);
+        for (size_t p = 0; p != row.size(); ++p) insert(row, p);
+    }
+
+    /// Positions in row, size is a power of two
+    std::vector<int> table;
+
+    /// Logarithm of the table size to base two
+    int log2_size = 0;
+
+};
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_ROWINDEX_H_ */
@@ -0,0 +1,182 @@
+/*
+ * SparseForceMatrix.cpp
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "gromacs/utility/fatalerror.h"
+#include "SparseForceMatrix.h"
+
+namespace fda {
+
+SparseForceMatrix::SparseForceMatrix(int dim)
+ : dim_(dim),
+   row_offsets_(dim + 1, 0)
+{}
+
+SparseForceMatrix::SparseForceMatrix(std::vector<double> const& dense)
+ : dim_(std::sqrt(dense.size())),
+   row_offsets_(1, 0)
+{
+    if (static_cast<size_t>(dim_) * dim_ != dense.size()) gmx_fatal(FARGS, "Dense force matrix is not square.");
+    for (int i = 0; i != dim_; ++i) {
+        for (int j = 0; j != dim_; ++j) {
+            double value = dense[i * dim_ + j];
+            if (value == 0.0) continue;
+            columns_.push_back(j);
+            values_.push_back(value);
+        }
+        row_offsets_.push_back(values_.size());
+    }
+}
+
+void SparseForceMatrix::reset(int dim)
+{
+    dim_ = dim;
+    row_offsets_.assign(dim + 1, 0);
+    columns_.clear();
+    values_.clear();
+    pending_.clear();
+}
+
+void SparseForceMatrix::set_symmetric(int i, int j, double value)
+{
+    if (i < 0 or i >= dim_ or j < 0 or j >= dim_) gmx_fatal(FARGS, "Index is larger than dimension.");
+    pending_.push_back({i, j, value});
+    if (i != j) pending_.push_back({j, i, value});
+}
+
+void SparseForceMatrix::compress()
+{
+    // Stable sort keeps the order of the set_symmetric calls for identical elements
+    std::stable_sort(pending_.begin(), pending_.end(), [](Element const& e1, Element const& e2) {
+        return e1.row < e2.row or (e1.row == e2.row and e1.column < e2.column);
+    });
+
+    columns_.clear();
+    values_.clear();
+    row_offsets_.assign(dim_ + 1, 0);
+    for (size_t n = 0; n != pending_.size(); ++n) {
+        Element const& e = pending_[n];
+        // The last value of an element wins
+        if (n + 1 != pending_.size() and pending_[n + 1].row == e.row and pending_[n + 1].column == e.column) continue;
+        if (e.value == 0.0) continue;
+        columns_.push_back(e.column);
+        values_.push_back(e.value);
+        ++row_offsets_[e.row + 1];
+    }
+    for (int i = 0; i != dim_; ++i) row_offsets_[i + 1] += row_offsets_[i];
+    pending_.clear();
+}
+
+double SparseForceMatrix::operator () (int i, int j) const
+{
+    auto row_columns = columns(i);
+    auto iter = std::lower_bound(row_columns.begin(), row_columns.end(), j);
+    if (iter == row_columns.end() or *iter != j) return 0.0;
+    return values_[row_offsets_[i] + (iter - row_columns.begin())];
+}
+
+std::vector<double> SparseForceMatrix::to_dense() const
+{
+    std::vector<double> dense(static_cast<size_t>(dim_) * dim_, 0.0);
+    for (int i = 0; i != dim_; ++i) {
+        for (size_t n = row_offsets_[i]; n != row_offsets_[i + 1]; ++n) {
+            dense[static_cast<size_t>(i) * dim_ + columns_[n]] = values_[n];
+        }
+    }
+    return dense;
+}
+
+SparseForceMatrix& SparseForceMatrix::operator += (SparseForceMatrix const& other)
+{
+    merge(other, 1.0);
+    return *this;
+}
+
+SparseForceMatrix& SparseForceMatrix::operator -= (SparseForceMatrix const& other)
+{
+    merge(other, -1.0);
+    return *this;
+}
+
+SparseForceMatrix& SparseForceMatrix::operator *= (double factor)
+{
+    for (auto& value : values_) value *= factor;
+    remove_zeros();
+    return *this;
+}
+
+SparseForceMatrix& SparseForceMatrix::operator /= (double divisor)
+{
+    for (auto& value : values_) value /= divisor;
+    remove_zeros();
+    return *this;
+}
+
+void SparseForceMatrix::abs()
+{
+    for (auto& value : values_) value = std::abs(value);
+}
+
+void SparseForceMatrix::merge(SparseForceMatrix const& other, double sign)
+{
+    if (dim_ != other.dim_) gmx_fatal(FARGS, "Dimensions of the force matrices are not identical.");
+
+    std::vector<size_t> row_offsets(1, 0);
+    std::vector<int> columns;
+    std::vector<double> values;
+    columns.reserve(columns_.size() + other.columns_.size());
+    values.reserve(values_.size() + other.values_.size());
+
+    for (int i = 0; i != dim_; ++i) {
+        size_t n1 = row_offsets_[i], end1 = row_offsets_[i + 1];
+        size_t n2 = other.row_offsets_[i], end2 = other.row_offsets_[i + 1];
+        while (n1 != end1 or n2 != end2) {
+            int column;
+            double value;
+            if (n2 == end2 or (n1 != end1 and columns_[n1] < other.columns_[n2])) {
+                column = columns_[n1];
+                value = values_[n1++];
+            } else if (n1 == end1 or other.columns_[n2] < columns_[n1]) {
+                column = other.columns_[n2];
+                value = sign > 0.0 ? other.values_[n2++] : -other.values_[n2++];
+            } else {
+                column = columns_[n1];
+                value = sign > 0.0 ? values_[n1++] + other.values_[n2++] : values_[n1++] - other.values_[n2++];
+            }
+            if (value == 0.0) continue;
+            columns.push_back(column);
+            values.push_back(value);
+        }
+        row_offsets.push_back(values.size());
+    }
+
+    row_offsets_.swap(row_offsets);
+    columns_.swap(columns);
+    values_.swap(values);
+}
+
+void SparseForceMatrix::remove_zeros()
+{
+    size_t m = 0;
+    size_t begin = 0;
+    for (int i = 0; i != dim_; ++i) {
+        size_t end = row_offsets_[i + 1];
+        for (size_t n = begin; n != end; ++n) {
+            if (values_[n] == 0.0) continue;
+            columns_[m] = columns_[n];
+            values_[m] = values_[n];
+            ++m;
+        }
+        begin = end;
+        row_offsets_[i + 1] = m;
+    }
+    columns_.resize(m);
+    values_.resize(m);
+}
+
+} // namespace fda
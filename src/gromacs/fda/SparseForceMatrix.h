@@ -0,0 +1,111 @@
+/*
+ * SparseForceMatrix.h
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_SPARSEFORCEMATRIX_H_
+#define SRC_GROMACS_FDA_SPARSEFORCEMATRIX_H_
+
+#include <cstddef>
+#include <vector>
+#include "gromacs/utility/arrayref.h"
+
+namespace fda {
+
+/**
+ * Square force matrix in compressed sparse row (CSR) format
+ *
+ * Only non-zero elements are stored, the column indices within a row are sorted.
+ * Elements which are not stored are zero, as in the dense force matrix of
+ * PairwiseForces::get_forcematrix_of_frame.
+ */
+class SparseForceMatrix
+{
+public:
+
+    SparseForceMatrix(int dim = 0);
+
+    /// Conversion from a dense square matrix
+    SparseForceMatrix(std::vector<double> const& dense);
+
+    /// Start a new matrix of dimension dim
+    void reset(int dim);
+
+    /// Set the elements (i, j) and (j, i), a later value of the same pair replaces the former one
+    void set_symmetric(int i, int j, double value);
+
+    /// Build the compressed rows after the last set_symmetric
+    void compress();
+
+    int dim() const { return dim_; }
+
+    /// Number of stored elements
+    size_t nonzeros() const { return values_.size(); }
+
+    /// Column indices of the stored elements of a row
+    gmx::ArrayRef<const int> columns(int row) const
+    {
+        return gmx::ArrayRef<const int>(columns_.data() + row_offsets_[row], columns_.data() + row_offsets_[row + 1]);
+    }
+
+    /// Values of the stored elements of a row
+    gmx::ArrayRef<const double> values(int row) const
+    {
+        return gmx::ArrayRef<const double>(values_.data() + row_offsets_[row], values_.data() + row_offsets_[row + 1]);
+    }
+
+    /// Element (i, j), zero if not stored
+    double operator () (int i, int j) const;
+
+    std::vector<double> to_dense() const;
+
+    SparseForceMatrix& operator += (SparseForceMatrix const& other);
+
+    SparseForceMatrix& operator -= (SparseForceMatrix const& other);
+
+    SparseForceMatrix& operator *= (double factor);
+
+    SparseForceMatrix& operator /= (double divisor);
+
+    /// Replace all elements by their absolute values
+    void abs();
+
+    bool operator == (SparseForceMatrix const& other) const
+    {
+        return dim_ == other.dim_ and row_offsets_ == other.row_offsets_ and columns_ == other.columns_ and values_ == other.values_;
+    }
+
+private:
+
+    /// Merge the elements of other, sign is +1 or -1
+    void merge(SparseForceMatrix const& other, double sign);
+
+    /// Remove elements which became zero
+    void remove_zeros();
+
+    struct Element
+    {
+        int row;
+        int column;
+        double value;
+    };
+
+    int dim_;
+
+    /// Begin of each row in columns_ and values_, size is dim_ + 1
+    std::vector<size_t> row_offsets_;
+
+    std::vector<int> columns_;
+
+    std::vector<double> values_;
+
+    /// Elements set since the last reset, sorted into rows by compress
+    std::vector<Element> pending_;
+
+};
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_SPARSEFORCEMATRIX_H_ */
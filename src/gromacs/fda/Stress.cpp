@@ -6,18 +6,40 @@
  */
 
 #include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <stdexcept>
+#include <utility>
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/gmxana/fda/Helpers.h"
+#include "MappedFile.h"
 #include "ResultType.h"
 #include "Stress.h"
 
 namespace fda {
 
+namespace {
+
+/// The binary format starts with 'b' and the number of values per frame
+constexpr uint64_t binary_header_size = 1 + sizeof(uint);
+
+/// Returns the number of values per frame and the number of frames of a binary stress file
+std::pair<uint, uint64_t> get_binary_layout(char const* data, uint64_t length, std::string const& filename)
+{
+    if (length < binary_header_size or data[0] != 'b') gmx_fatal(FARGS, "Wrong file type of %s", filename.c_str());
+    uint nb_values;
+    std::memcpy(&nb_values, data + 1, sizeof(uint));
+    uint64_t frame_size = nb_values * sizeof(real);
+    if (frame_size == 0 or (length - binary_header_size) % frame_size != 0)
+        gmx_fatal(FARGS, "Size of file %s does not match %u values per frame", filename.c_str(), nb_values);
+    return std::make_pair(nb_values, (length - binary_header_size) / frame_size);
+}
+
+} // namespace
+
 Stress::Stress(std::string const& filename)
  : filename(filename),
    is_binary(false)
@@ -70,25 +92,13 @@ Stress::StressFrameArrayType Stress::get_stress() const
 {
     StressFrameArrayType stress_all_frames;
     if (this->is_binary) {
-        std::ifstream is(filename, std::ifstream::binary);
-        if (!is) gmx_fatal(FARGS, "Error opening file.");
-
-        // get length of file:
-        is.seekg (0, is.end);
-        int length = is.tellg();
-        is.seekg (0, is.beg);
-
-        char first_character;
-        is.read(&first_character, 1);
-        if (first_character != 'b') gmx_fatal(FARGS, "Wrong file type in Stress::write");
-
-        uint syslen;
-        is.read(reinterpret_cast<char*>(&syslen), sizeof(uint));
-        StressType stress(syslen);
-        for (;;) {
-            is.read(reinterpret_cast<char*>(&stress[0]), syslen * sizeof(real));
-            stress_all_frames.push_back(stress);
-            if (is.tellg() == length) break;
+        // Frames have a fixed size and are copied directly from the mapped file
+        MappedFile file(filename);
+        auto layout = get_binary_layout(file.data(), file.size(), filename);
+        stress_all_frames.resize(layout.second, StressType(layout.first));
+        for (uint64_t frame = 0; frame != layout.second; ++frame) {
+            std::memcpy(stress_all_frames[frame].data(), file.data() + binary_header_size + frame * layout.first * sizeof(real),
+                layout.first * sizeof(real));
         }
     } else {
         std::ifstream is(filename);
@@ -124,4 +134,37 @@ Stress::StressFrameArrayType Stress::get_stress() const
     return stress_all_frames;
 }
 
+Stress::StressType Stress::get_frame(size_t frame) const
+{
+    if (this->is_binary) {
+        std::ifstream is(filename, std::ifstream::binary);
+        if (!is) gmx_fatal(FARGS, "Error opening file.");
+        char first_character;
+        uint nb_values;
+        is.read(&first_character, 1);
+        is.read(reinterpret_cast<char*>(&nb_values), sizeof(uint));
+        if (!is or first_character != 'b') gmx_fatal(FARGS, "Wrong file type of %s", filename.c_str());
+
+        // Frames have a fixed size, so that the frame can be read directly
+        StressType stress(nb_values);
+        is.seekg(binary_header_size + frame * nb_values * sizeof(real));
+        is.read(reinterpret_cast<char*>(stress.data()), nb_values * sizeof(real));
+        if (!is) gmx_fatal(FARGS, "Frame %zu not found in %s", frame, filename.c_str());
+        return stress;
+    }
+
+    auto&& stress_all_frames = get_stress();
+    if (frame >= stress_all_frames.size()) gmx_fatal(FARGS, "Frame %zu not found in %s", frame, filename.c_str());
+    return stress_all_frames[frame];
+}
+
+size_t Stress::get_number_of_frames() const
+{
+    if (this->is_binary) {
+        MappedFile file(filename);
+        return get_binary_layout(file.data(), file.size(), filename).second;
+    }
+    return get_stress().size();
+}
+
 } // namespace fda
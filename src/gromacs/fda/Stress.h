@@ -14,7 +14,13 @@
 
 namespace fda {
 
-/// Read and write punctual and virial stress files
+/**
+ * Read and write punctual and virial stress files
+ *
+ * The binary format starts with the character 'b' and the number of values per frame as uint,
+ * followed by the frames as arrays of real with fixed size. The virial stress has six values
+ * (XX, YY, ZZ, XY, XZ, YZ) per atom.
+ */
 struct Stress
 {
 	typedef std::vector<real> StressType;
@@ -45,6 +51,11 @@ struct Stress
     /// Read stress from file
     StressFrameArrayType get_stress() const;
 
+    /// Read the stress of a single frame, binary files are not read before the frame
+    StressType get_frame(size_t frame) const;
+
+    size_t get_number_of_frames() const;
+
     /// Write stress to file
     void write(std::string const& out_filename, bool out_binary = false) const;
 
@@ -0,0 +1,39 @@
+/*
+ * VirialStress.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <algorithm>
+#include "VirialStress.h"
+
+namespace fda {
+
+constexpr int VirialStress::stride;
+
+void VirialStress::add_and_clear(VirialStress& other, int begin, int end)
+{
+    real *t = values.data() + begin * stride;
+    real *o = other.values.data() + begin * stride;
+    real *t_end = values.data() + end * stride;
+#if GMX_SIMD4_HAVE_REAL
+    gmx::Simd4Real zero_S = gmx::setZero();
+    for (; t != t_end; t += GMX_SIMD4_WIDTH, o += GMX_SIMD4_WIDTH) {
+        gmx::store4(t, gmx::load4(t) + gmx::load4(o));
+        gmx::store4(o, zero_S);
+    }
+#else
+    for (; t != t_end; ++t, ++o) {
+        *t += *o;
+        *o = 0.0;
+    }
+#endif
+}
+
+void VirialStress::clear()
+{
+    std::fill(values.begin(), values.end(), 0.0);
+}
+
+} // namespace fda
@@ -0,0 +1,87 @@
+/*
+ * VirialStress.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_VIRIALSTRESS_H_
+#define SRC_GROMACS_FDA_VIRIALSTRESS_H_
+
+#include <vector>
+#include "gromacs/simd/simd.h"
+#include "gromacs/utility/alignedallocator.h"
+#include "gromacs/utility/real.h"
+
+namespace fda {
+
+/**
+ * Virial stress per atom. As the atom virial is symmetric, only the six components
+ * XX, YY, ZZ, XY, XZ and YZ are stored. Each tensor is padded to eight reals,
+ * so that it can be updated with two aligned SIMD4 operations.
+ */
+class VirialStress
+{
+public:
+
+    /// Number of reals per atom
+    static constexpr int stride = 8;
+
+    /// Positions of the components in the packed tensor
+    enum Component { xx = 0, yy = 1, zz = 2, xy = 3, xz = 4, yz = 5 };
+
+    /// Packed symmetric tensor of one interaction, the padding must be zero
+    struct alignas(GMX_SIMD_ALIGNMENT) Packed
+    {
+        real v[stride] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    };
+
+    VirialStress(int syslen = 0)
+     : syslen(syslen),
+       values(syslen * stride, 0.0)
+    {}
+
+    /// Number of atoms
+    int size() const { return syslen; }
+
+    /// Packed tensor of atom i
+    real const* operator [] (int i) const { return values.data() + i * stride; }
+
+    /// Add s * v to the tensor of atom i
+    void add(int i, Packed const& v, real s)
+    {
+        real *t = values.data() + i * stride;
+#if GMX_SIMD4_HAVE_REAL
+        gmx::Simd4Real s_S(s);
+        gmx::store4(t, gmx::fma(s_S, gmx::load4(v.v), gmx::load4(t)));
+        gmx::store4(t + GMX_SIMD4_WIDTH, gmx::fma(s_S, gmx::load4(v.v + GMX_SIMD4_WIDTH), gmx::load4(t + GMX_SIMD4_WIDTH)));
+#else
+        for (int c = 0; c != 6; ++c) t[c] += s * v.v[c];
+#endif
+    }
+
+    /// Add the tensors of the atoms [begin, end) of other and clear them in other
+    void add_and_clear(VirialStress& other, int begin, int end);
+
+    /// Set all tensors to zero
+    void clear();
+
+    /// All reals, e.g. for the summation over MPI ranks
+    real* data() { return values.data(); }
+
+    /// Number of reals
+    int data_size() const { return values.size(); }
+
+private:
+
+    /// Number of atoms
+    int syslen;
+
+    /// Packed tensors of all atoms
+    std::vector<real, gmx::AlignedAllocator<real>> values;
+
+};
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_VIRIALSTRESS_H_ */
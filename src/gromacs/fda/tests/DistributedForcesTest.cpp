@@ -0,0 +1,227 @@
+/*
+ * DistributedForcesTest.cpp
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <gtest/gtest.h>
+#include "gromacs/fda/DistributedForces.h"
+
+namespace fda {
+
+TEST(DistributedForcesTest, SummedKeepsInsertionOrder)
+{
+    FDASettings fda_settings;
+    DistributedForces distributed_forces(100, fda_settings);
+
+    // More than 16 entries in row 0 to switch from linear search to hashing
+    std::vector<int> js;
+    for (int j = 99; j > 40; j -= 2) js.push_back(j);
+    for (int j : js) distributed_forces.add_summed(0, j, Vector(1.0), InteractionType_COULOMB);
+    for (int j : js) distributed_forces.add_summed(0, j, Vector(2.0), InteractionType_LJ);
+    distributed_forces.add_summed(3, 7, Vector(1.0), InteractionType_BOND);
+
+    std::stringstream ss;
+    distributed_forces.write_summed_vector(ss);
+
+    int i, j, type;
+    Vector force;
+    for (int expected_j : js) {
+        ss >> i >> j >> force >> type;
+        EXPECT_EQ(0, i);
+        EXPECT_EQ(expected_j, j);
+        EXPECT_FLOAT_EQ(3.0, force[0]);
+        EXPECT_EQ(InteractionType_COULOMB | InteractionType_LJ, type);
+    }
+    ss >> i >> j >> force >> type;
+    EXPECT_EQ(3, i);
+    EXPECT_EQ(7, j);
+    EXPECT_FALSE(ss >> i);
+
+    // After clearing, the rows must be usable again
+    distributed_forces.clear();
+    distributed_forces.add_summed(0, 50, Vector(1.0), InteractionType_LJ);
+    std::stringstream ss2;
+    distributed_forces.write_summed_vector(ss2);
+    ss2 >> i >> j >> force >> type;
+    EXPECT_EQ(50, j);
+    EXPECT_FALSE(ss2 >> i);
+}
+
+TEST(DistributedForcesTest, ActiveRowsAreWrittenInOrder)
+{
+    FDASettings fda_settings;
+    DistributedForces distributed_forces(100, fda_settings);
+
+    distributed_forces.add_summed(50, 60, Vector(1.0), InteractionType_COULOMB);
+    distributed_forces.add_summed(2, 60, Vector(1.0), InteractionType_COULOMB);
+    distributed_forces.add_summed(50, 70, Vector(1.0), InteractionType_COULOMB);
+
+    std::stringstream ss;
+    distributed_forces.write_summed_vector(ss);
+
+    int i, j, type;
+    Vector force;
+    std::vector<std::pair<int, int>> written;
+    while (ss >> i >> j >> force >> type) written.emplace_back(i, j);
+    EXPECT_EQ((std::vector<std::pair<int, int>>{{2, 60}, {50, 60}, {50, 70}}), written);
+
+    // Only the rows of the new frame are written after clearing
+    distributed_forces.clear();
+    distributed_forces.add_summed(7, 8, Vector(1.0), InteractionType_LJ);
+    std::stringstream ss2;
+    distributed_forces.write_summed_vector(ss2);
+    ss2 >> i >> j >> force >> type;
+    EXPECT_EQ(7, i);
+    EXPECT_EQ(8, j);
+    EXPECT_FALSE(ss2 >> i);
+}
+
+TEST(DistributedForcesTest, SortRowsIsIndependentOfThreadOrder)
+{
+    FDASettings fda_settings;
+    DistributedForces thread0(100, fda_settings), thread1(100, fda_settings);
+
+    // Row 0 has more than 16 entries to check the rebuilt hash table
+    for (int j = 1; j < 60; j += 3) thread0.add_summed(0, j, Vector(1.0), InteractionType_COULOMB);
+    for (int j = 98; j > 30; j -= 4) thread1.add_summed(0, j, Vector(2.0), InteractionType_LJ);
+    thread0.add_summed(5, 9, Vector(1.0), InteractionType_BOND);
+    thread1.add_summed(5, 6, Vector(1.0), InteractionType_ANGLE);
+
+    std::string written[2];
+    for (int order = 0; order != 2; ++order) {
+        // The rows must be active before add_row is called
+        DistributedForces distributed_forces(100, fda_settings);
+        distributed_forces.add_summed(0, 1, Vector(0.0), InteractionType_COULOMB);
+        distributed_forces.add_summed(5, 6, Vector(0.0), InteractionType_ANGLE);
+        for (DistributedForces const* thread : {order ? &thread1 : &thread0, order ? &thread0 : &thread1}) {
+            for (int i : {0, 5}) distributed_forces.add_row(i, *thread);
+        }
+        distributed_forces.sort_rows();
+        distributed_forces.add_summed(0, 34, Vector(1.0), InteractionType_COULOMB);
+
+        std::stringstream ss;
+        distributed_forces.write_summed_vector(ss);
+        written[order] = ss.str();
+
+        int i, j, last_i = -1, last_j = -1, type;
+        Vector force;
+        while (ss >> i >> j >> force >> type) {
+            EXPECT_TRUE(i > last_i or j > last_j);
+            // Pair (0, 34) is in both threads and was added once more after sorting
+            if (i == 0 and j == 34) EXPECT_FLOAT_EQ(4.0, force[0]);
+            last_i = i;
+            last_j = j;
+        }
+    }
+    EXPECT_EQ(written[0], written[1]);
+}
+
+TEST(DistributedForcesTest, DetailedStoresOnlyPresentTypes)
+{
+    FDASettings fda_settings;
+    DistributedForces distributed_forces(10, fda_settings), other(10, fda_settings);
+
+    distributed_forces.add_detailed(0, 1, Vector(1.0), PureInteractionType::LJ);
+    distributed_forces.add_detailed(0, 2, Vector(1.0), PureInteractionType::BOND);
+    // Slab of pair (0, 1) is not the last one anymore and must be moved
+    distributed_forces.add_detailed(0, 1, Vector(2.0), PureInteractionType::COULOMB);
+    distributed_forces.add_detailed(0, 1, Vector(3.0), PureInteractionType::LJ);
+    distributed_forces.add_detailed(0, 2, Vector(4.0), PureInteractionType::ANGLE);
+
+    other.add_detailed(0, 2, Vector(5.0), PureInteractionType::NB14);
+    other.add_detailed(0, 3, Vector(6.0), PureInteractionType::POLAR);
+    distributed_forces.add_row(0, other);
+
+    std::stringstream ss;
+    distributed_forces.write_detailed_vector(ss);
+
+    std::vector<std::tuple<int, int, real, int>> expected = {
+        {0, 1, 2.0, InteractionType_COULOMB}, {0, 1, 4.0, InteractionType_LJ},
+        {0, 2, 1.0, InteractionType_BOND}, {0, 2, 4.0, InteractionType_ANGLE}, {0, 2, 5.0, InteractionType_NB14},
+        {0, 3, 6.0, InteractionType_POLAR}
+    };
+
+    int i, j, type;
+    Vector force;
+    for (auto const& e : expected) {
+        ASSERT_TRUE(static_cast<bool>(ss >> i >> j >> force >> type));
+        EXPECT_EQ(std::get<0>(e), i);
+        EXPECT_EQ(std::get<1>(e), j);
+        EXPECT_FLOAT_EQ(std::get<2>(e), force[2]);
+        EXPECT_EQ(std::get<3>(e), type);
+    }
+    EXPECT_FALSE(ss >> i);
+}
+
+TEST(DistributedForcesTest, DirectPunctualStress)
+{
+    FDASettings fda_settings;
+    fda_settings.one_pair = OnePair::SUMMED;
+    DistributedForces summed(5, fda_settings), direct(5, fda_settings, true);
+
+    real f01[3] = {1.0, 2.0, 2.0};
+    real f13[3] = {0.0, -4.0, 3.0};
+    for (auto& forces : {&summed, &direct}) {
+        forces->add_summed(0, 1, Vector(f01), InteractionType_COULOMB);
+        forces->add_summed(1, 3, Vector(f13), InteractionType_LJ);
+    }
+
+    gmx::PaddedHostVector<gmx::RVec> x(5, gmx::RVec(0.0, 0.0, 0.0));
+    std::stringstream ss_summed, ss_direct;
+    summed.write_total_forces(ss_summed, x);
+    direct.write_total_forces(ss_direct, x);
+    EXPECT_EQ("3 8 0 5 0\n", ss_direct.str());
+    EXPECT_EQ(ss_summed.str(), ss_direct.str());
+
+    // Pairs are not stored, a second contribution of a pair is added by its norm
+    real f01_bond[3] = {-1.0, -2.0, -2.0};
+    direct.add_summed(0, 1, Vector(f01_bond), InteractionType_BOND);
+    std::stringstream ss_direct2;
+    direct.write_total_forces(ss_direct2, x);
+    EXPECT_EQ("6 11 0 5 0\n", ss_direct2.str());
+
+    direct.clear();
+    std::stringstream ss_cleared;
+    direct.write_total_forces(ss_cleared, x);
+    EXPECT_EQ("0 0 0 0 0\n", ss_cleared.str());
+}
+
+TEST(DistributedForcesTest, PackedForcesOfOtherRank)
+{
+    FDASettings fda_settings;
+    fda_settings.one_pair = OnePair::SUMMED;
+    DistributedForces master(10, fda_settings), rank(10, fda_settings);
+
+    master.add_summed(1, 2, Vector(1.0), InteractionType_COULOMB);
+    rank.add_summed(1, 2, Vector(2.0), InteractionType_LJ);
+    rank.add_summed(3, 4, Vector(3.0), InteractionType_BOND);
+
+    std::vector<PackedForce> buffer;
+    rank.pack(buffer);
+    ASSERT_EQ(2U, buffer.size());
+    master.add_packed(buffer.data(), buffer.data() + buffer.size());
+
+    std::stringstream ss;
+    master.write_summed_vector(ss);
+
+    int i, j, type;
+    Vector force;
+    ASSERT_TRUE(static_cast<bool>(ss >> i >> j >> force >> type));
+    EXPECT_EQ(1, i);
+    EXPECT_EQ(2, j);
+    EXPECT_FLOAT_EQ(3.0, force[0]);
+    EXPECT_EQ(InteractionType_COULOMB | InteractionType_LJ, type);
+    ASSERT_TRUE(static_cast<bool>(ss >> i >> j >> force >> type));
+    EXPECT_EQ(3, i);
+    EXPECT_EQ(4, j);
+    EXPECT_EQ(InteractionType_BOND, type);
+    EXPECT_FALSE(ss >> i);
+}
+
+} // namespace fda
@@ -0,0 +1,81 @@
+/*
+ * NonbondedBufferTest.cpp
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <vector>
+#include <gtest/gtest.h>
+#include "gromacs/fda/ClusterGroupBits.h"
+#include "gromacs/fda/NonbondedBuffer.h"
+
+namespace fda {
+
+TEST(NonbondedBufferTest, ClusterPairIsMasked)
+{
+    FDASettings fda_settings;
+    fda_settings.sys_in_group1 = {1, 1, 0, 0, 0, 0};
+    fda_settings.sys_in_group2 = {0, 0, 0, 0, 1, 1};
+
+    NonbondedBuffer buffer(fda_settings);
+
+    // i-cluster {0, 1}, j-cluster {4, 5, -1} with a filler atom
+    std::vector<int> ai = {0, 1};
+    std::vector<int> aj = {4, 5, -1};
+
+    // pair (1, 5) beyond the cut-off
+    std::vector<real> wco   = {1.0, 1.0, 1.0, 1.0, 0.0, 1.0};
+    std::vector<real> fcoul = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+    std::vector<real> flj   = {0.1, 0.2, 0.3, 0.0, 0.0, 0.0};
+    std::vector<real> d     = {1.0, 1.0, 1.0, 1.0, 1.0, 1.0};
+
+    // Only i-atom 0 has LJ
+    buffer.add_cluster_pair<2, 3>(ai.data(), aj.data(), 1, true,
+        wco.data(), fcoul.data(), flj.data(), d.data(), d.data(), d.data());
+
+    ASSERT_EQ(3, buffer.size());
+    EXPECT_EQ(0, buffer.i[0]);
+    EXPECT_EQ(4, buffer.j[0]);
+    EXPECT_EQ(InteractionType_COULOMB | InteractionType_LJ, buffer.type[0]);
+    EXPECT_FLOAT_EQ(0.2, buffer.flj[1]);
+    EXPECT_EQ(1, buffer.i[2]);
+    EXPECT_EQ(4, buffer.j[2]);
+    EXPECT_EQ(InteractionType_COULOMB, buffer.type[2]);
+    EXPECT_FLOAT_EQ(4.0, buffer.fcoul[2]);
+
+    buffer.clear();
+    EXPECT_EQ(0, buffer.size());
+}
+
+TEST(NonbondedBufferTest, ClusterGroupBits)
+{
+    FDASettings fda_settings;
+    fda_settings.sys_in_group1 = {1, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    fda_settings.sys_in_group2 = {0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+
+    // nbnxm order: cluster 0 {0, 1, 2, -1}, cluster 1 {3, 4, 5, 6}, cluster 2 {7, 8, 9, -1},
+    // cluster 3 only fillers to pad the atoms to the j-cluster size 8
+    std::vector<int> cellInv = {0, 1, 2, -1, 3, 4, 5, 6, 7, 8, 9, -1, -1, -1, -1, -1};
+
+    ClusterGroupBits bits;
+    bits.update(fda_settings, cellInv.data(), cellInv.size());
+
+    EXPECT_EQ(1, bits.i_cluster(0));
+    EXPECT_EQ(0, bits.i_cluster(1));
+    EXPECT_EQ(2, bits.i_cluster(2));
+    EXPECT_TRUE(ClusterGroupBits::pair_in_groups(bits.i_cluster(0), bits.j_cluster(2, 4)));
+    EXPECT_FALSE(ClusterGroupBits::pair_in_groups(bits.i_cluster(0), bits.j_cluster(1, 4)));
+    EXPECT_FALSE(ClusterGroupBits::pair_in_groups(bits.i_cluster(2), bits.j_cluster(2, 4)));
+
+    // j-clusters of size 8 and 2
+    EXPECT_EQ(1, bits.j_cluster(0, 8));
+    EXPECT_EQ(2, bits.j_cluster(1, 8));
+    EXPECT_EQ(0, bits.j_cluster(3, 2));
+    EXPECT_EQ(2, bits.j_cluster(5, 2));
+
+    bits.clear(cellInv.size());
+    EXPECT_EQ(0, bits.i_cluster(0));
+}
+
+} // namespace fda
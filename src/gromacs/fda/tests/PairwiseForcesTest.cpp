@@ -7,6 +7,7 @@
 
 #include <iostream>
 #include <gtest/gtest.h>
+#include "gromacs/fda/MappedPairwiseForces.h"
 #include "gromacs/fda/PairwiseForces.h"
 #include "testutils/cmdlinetest.h"
 #include "testutils/testfilemanager.h"
@@ -65,4 +66,147 @@ TEST_F(PairwiseForcesTest, ReadFile3)
     EXPECT_EQ(17, pf_all[8][5].j);
 }
 
+TEST_F(PairwiseForcesTest, BinaryRoundTrip)
+{
+    std::string data_path = std::string(fileManager().getInputDataDirectory()) + "/data";
+    std::string binary_filename = fileManager().getTemporaryFilePath("pfa.bin");
+
+    PairwiseForces<Force<real>> pf(data_path + "/test2.pfa");
+    pf.write(binary_filename, true);
+
+    PairwiseForces<Force<real>> pf_binary(binary_filename);
+    EXPECT_TRUE(pf_binary.get_is_binary());
+    EXPECT_TRUE(pf_binary.get_is_indexed());
+    EXPECT_EQ(11, pf_binary.get_number_of_frames());
+    EXPECT_EQ(pf.get_all_pairwise_forces(true), pf_binary.get_all_pairwise_forces(true));
+
+    int nb_particles = pf.get_max_index_second_column_first_frame() + 1;
+    EXPECT_EQ(pf.get_forcematrix_of_frame(nb_particles, 7), pf_binary.get_forcematrix_of_frame(nb_particles, 7));
+}
+
+TEST_F(PairwiseForcesTest, MappedFrames)
+{
+    std::string data_path = std::string(fileManager().getInputDataDirectory()) + "/data";
+    std::string binary_filename = fileManager().getTemporaryFilePath("pfa.bin");
+
+    PairwiseForces<Force<Vector>> pf(data_path + "/test3.pfa");
+    pf.write(binary_filename, true);
+
+    MappedPairwiseForces<3> mapped(binary_filename);
+    auto&& pf_all = pf.get_all_pairwise_forces();
+    EXPECT_EQ(pf_all.size(), mapped.get_number_of_frames());
+    for (size_t frame = 0; frame != pf_all.size(); ++frame) {
+        auto entries = mapped.get_frame(frame);
+        ASSERT_EQ(pf_all[frame].size(), entries.size());
+        for (size_t i = 0; i != entries.size(); ++i) {
+            EXPECT_EQ(pf_all[frame][i].i, entries[i].i);
+            EXPECT_EQ(pf_all[frame][i].j, entries[i].j);
+            EXPECT_EQ(pf_all[frame][i].force.force[2], entries[i].force[2]);
+            EXPECT_EQ(pf_all[frame][i].force.type, entries[i].type);
+        }
+    }
+}
+
+TEST_F(PairwiseForcesTest, FrameReader)
+{
+    std::string data_path = std::string(fileManager().getInputDataDirectory()) + "/data";
+    std::string binary_filename = fileManager().getTemporaryFilePath("pfa.bin");
+
+    PairwiseForces<Force<real>> pf(data_path + "/test2.pfa");
+    pf.write(binary_filename, true);
+    PairwiseForces<Force<real>> pf_binary(binary_filename);
+
+    int nb_particles = pf.get_max_index_second_column_first_frame() + 1;
+    auto pf_all = pf.get_all_pairwise_forces();
+
+    for (auto&& p : {&pf, &pf_binary}) {
+        auto reader = p->get_frame_reader();
+        std::vector<double> forcematrix;
+        std::vector<PairwiseForce<Force<real>>> pairwise_forces;
+        EXPECT_TRUE(reader.next(pairwise_forces));
+        EXPECT_EQ(pf_all[0], pairwise_forces);
+        EXPECT_TRUE(reader.skip());
+        for (int frame = 2; frame != 11; ++frame) {
+            EXPECT_TRUE(reader.next_forcematrix(forcematrix, nb_particles));
+            EXPECT_EQ(pf.get_forcematrix_of_frame(nb_particles, frame), forcematrix);
+        }
+        EXPECT_EQ(11, reader.get_frame());
+        EXPECT_FALSE(reader.next(pairwise_forces));
+        EXPECT_FALSE(reader.skip());
+    }
+}
+
+TEST_F(PairwiseForcesTest, FrameReaderDiff)
+{
+    std::string data_path = std::string(fileManager().getInputDataDirectory()) + "/data";
+    std::string binary_filename = fileManager().getTemporaryFilePath("pfa.bin");
+
+    PairwiseForces<Force<real>> pf(data_path + "/test2.pfa");
+    pf.write(binary_filename, true);
+    PairwiseForces<Force<real>> pf_binary(binary_filename);
+
+    int nb_particles = pf.get_max_index_second_column_first_frame() + 1;
+
+    // Difference of each frame to the following frame
+    for (auto&& p : {&pf, &pf_binary}) {
+        auto reader = p->get_frame_reader();
+        auto reader_other = p->get_frame_reader();
+        EXPECT_TRUE(reader_other.skip());
+        SparseForceMatrix forcematrix;
+        for (int frame = 0; frame != 10; ++frame) {
+            EXPECT_TRUE(reader.next_forcematrix_diff(reader_other, forcematrix, nb_particles));
+            SparseForceMatrix expected = p->get_sparse_forcematrix_of_frame(nb_particles, frame);
+            expected -= p->get_sparse_forcematrix_of_frame(nb_particles, frame + 1);
+            EXPECT_EQ(expected, forcematrix);
+        }
+        EXPECT_EQ(pf.get_sparse_forcematrix_diff_of_frame(pf_binary, nb_particles, 4).nonzeros(), 0u);
+    }
+}
+
+TEST_F(PairwiseForcesTest, FrameIndex)
+{
+    std::string data_path = std::string(fileManager().getInputDataDirectory()) + "/data";
+    std::string binary_filename = fileManager().getTemporaryFilePath("pfa.bin");
+    std::string legacy_filename = fileManager().getTemporaryFilePath("pfa_legacy.bin");
+
+    PairwiseForces<Force<real>> pf(data_path + "/test2.pfa");
+    pf.write(binary_filename, true);
+    PairwiseForces<Force<real>> pf_binary(binary_filename);
+    auto pf_all = pf.get_all_pairwise_forces();
+
+    // Legacy binary format: rows of interactions of the same atom i
+    {
+        std::ofstream os(legacy_filename, std::ofstream::binary);
+        os.put('b');
+        for (auto&& frame : pf_all) {
+            uint nb_interactions = frame.size();
+            os.write(reinterpret_cast<char*>(&nb_interactions), sizeof(uint));
+            for (auto&& e : frame) {
+                uint i = e.i, one = 1, j = e.j, type = e.force.type;
+                real force = e.force.force;
+                os.write(reinterpret_cast<char*>(&i), sizeof(uint));
+                os.write(reinterpret_cast<char*>(&one), sizeof(uint));
+                os.write(reinterpret_cast<char*>(&j), sizeof(uint));
+                os.write(reinterpret_cast<char*>(&force), sizeof(real));
+                os.write(reinterpret_cast<char*>(&type), sizeof(uint));
+            }
+        }
+    }
+    PairwiseForces<Force<real>> pf_legacy(legacy_filename);
+
+    for (auto&& p : {&pf, &pf_binary, &pf_legacy}) {
+        auto frame_index = p->get_frame_index();
+        EXPECT_EQ(p == &pf_binary ? 0 : 11, frame_index.size());
+        auto reader = p->get_frame_reader();
+        std::vector<PairwiseForce<Force<real>>> pairwise_forces;
+        for (int frame : {7, 0, 10, 3}) {
+            reader.seek(frame, frame_index);
+            EXPECT_TRUE(reader.next(pairwise_forces));
+            EXPECT_EQ(pf_all[frame], pairwise_forces);
+        }
+        reader.seek(11, frame_index);
+        EXPECT_FALSE(reader.next(pairwise_forces));
+    }
+}
+
 } // namespace fda
@@ -0,0 +1,73 @@
+/*
+ * SparseForceMatrixTest.cpp
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <cmath>
+#include <vector>
+#include <gtest/gtest.h>
+#include "gromacs/fda/PairwiseForces.h"
+#include "gromacs/fda/SparseForceMatrix.h"
+#include "testutils/cmdlinetest.h"
+#include "testutils/testfilemanager.h"
+
+namespace fda {
+
+TEST(SparseForceMatrixTest, LastValueWins)
+{
+    SparseForceMatrix m(3);
+    m.set_symmetric(0, 2, 1.0);
+    m.set_symmetric(1, 1, 2.0);
+    m.set_symmetric(2, 0, 3.0);
+    m.set_symmetric(0, 1, 4.0);
+    m.set_symmetric(1, 0, 0.0);
+    m.compress();
+
+    EXPECT_EQ(3, m.nonzeros());
+    EXPECT_EQ(3.0, m(0, 2));
+    EXPECT_EQ(3.0, m(2, 0));
+    EXPECT_EQ(2.0, m(1, 1));
+    EXPECT_EQ(0.0, m(0, 1));
+    EXPECT_EQ((std::vector<double>{0, 0, 3, 0, 2, 0, 3, 0, 0}), m.to_dense());
+}
+
+TEST(SparseForceMatrixTest, ArithmeticAsDense)
+{
+    std::vector<double> d1 = {0, 1, -2, 1, 0, 0, -2, 0, 5};
+    std::vector<double> d2 = {0, 1, 0, 1, 0, 3, 0, 3, 0};
+
+    SparseForceMatrix m1(d1), m2(d2);
+    m1 -= m2;
+    m1.abs();
+    m1 *= 1.66;
+    m1 += m2;
+    m1 /= 2;
+
+    for (size_t i = 0; i != d1.size(); ++i) d1[i] = (std::abs(d1[i] - d2[i]) * 1.66 + d2[i]) / 2;
+    EXPECT_EQ(d1, m1.to_dense());
+    EXPECT_EQ(SparseForceMatrix(d1), m1);
+}
+
+//! Test fixture for the sparse force matrix of PairwiseForces
+class SparseForceMatrixFileTest : public gmx::test::CommandLineTestBase
+{};
+
+TEST_F(SparseForceMatrixFileTest, SameAsDense)
+{
+    std::string data_path = std::string(fileManager().getInputDataDirectory()) + "/data";
+
+    PairwiseForces<Force<real>> pf(data_path + "/test2.pfa");
+    int nb_particles = pf.get_max_index_second_column_first_frame() + 1;
+
+    auto reader = pf.get_frame_reader();
+    SparseForceMatrix m;
+    for (int frame = 0; frame != 11; ++frame) {
+        EXPECT_TRUE(reader.next_forcematrix(m, nb_particles));
+        EXPECT_EQ(pf.get_forcematrix_of_frame(nb_particles, frame), m.to_dense());
+    }
+    EXPECT_EQ(pf.get_forcematrix_of_frame(nb_particles, 4), pf.get_sparse_forcematrix_of_frame(nb_particles, 4).to_dense());
+}
+
+} // namespace fda
@@ -0,0 +1,47 @@
+/*
+ * StressTest.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <fstream>
+#include <gtest/gtest.h>
+#include "gromacs/fda/Stress.h"
+#include "testutils/cmdlinetest.h"
+#include "testutils/testfilemanager.h"
+
+namespace fda
+{
+
+//! Test fixture for Stress
+class StressTest : public gmx::test::CommandLineTestBase
+{};
+
+TEST_F(StressTest, BinaryVirialStressFrames)
+{
+    std::string text_filename = fileManager().getTemporaryFilePath("stress.vsa");
+    std::string binary_filename = fileManager().getTemporaryFilePath("stress_binary.vsa");
+
+    // Two frames of two atoms with six values per atom
+    {
+        std::ofstream os(text_filename);
+        os << "virial_stress" << std::endl;
+        os << "1 2 3 4 5 6 7 8 9 10 11 12" << std::endl;
+        os << "-1 -2 -3 -4 -5 -6 -7 -8 -9 -10 -11 -12" << std::endl;
+    }
+
+    Stress stress(text_filename);
+    EXPECT_FALSE(stress.get_is_binary());
+    stress.write(binary_filename, true);
+
+    Stress stress_binary(binary_filename);
+    EXPECT_TRUE(stress_binary.get_is_binary());
+    EXPECT_EQ(2, stress_binary.get_number_of_frames());
+    EXPECT_EQ(stress.get_stress(), stress_binary.get_stress());
+    EXPECT_EQ(stress.get_frame(1), stress_binary.get_frame(1));
+    EXPECT_EQ(12, stress_binary.get_frame(1).size());
+    EXPECT_EQ(-12, stress_binary.get_frame(1)[11]);
+}
+
+} // namespace fda
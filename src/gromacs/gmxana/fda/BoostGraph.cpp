@@ -11,36 +11,83 @@
 #include <iomanip>
 #include <fstream>
 #include <limits>
+#include <memory>
 #include <sstream>
+#include <stdexcept>
 #include "BoostGraph.h"
 #include "Index.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxomp.h"
 
 namespace fda_analysis {
 
-BoostGraph::BoostGraph(std::vector<double> const& forceMatrix)
+namespace {
+
+//! Arity of the heap, as in boost::dijkstra_shortest_paths
+const size_t arity = 4;
+
+const char white = 0;
+const char gray = 1;
+const char black = 2;
+
+} // namespace
+
+BoostGraph::BoostGraph(fda::SparseForceMatrix const& forceMatrix)
 {
-    int dim = sqrt(forceMatrix.size());
-    double force;
+    int dim = forceMatrix.dim();
+
+    // Edge (i, j) with j >= i is stored in row i and j, the columns of each row are sorted.
+    std::vector<size_t> count(dim, 0);
+    for (int i = 0; i < dim; ++i) {
+        for (auto j : forceMatrix.columns(i)) {
+            if (j < i) continue;
+            ++count[i];
+            if (j != i) ++count[j];
+        }
+    }
+    rowOffsets_.assign(dim + 1, 0);
+    for (int i = 0; i < dim; ++i) rowOffsets_[i + 1] = rowOffsets_[i] + count[i];
+    columns_.resize(rowOffsets_[dim]);
+    weights_.resize(rowOffsets_[dim]);
 
+    std::vector<size_t> pos(rowOffsets_.begin(), rowOffsets_.end() - 1);
     for (int i = 0; i < dim; ++i) {
-        for (int j = i; j < dim; ++j) {
-            force = forceMatrix[i*dim+j];
-            if (force != 0.0) {
-                add_edge(i, j, force, graph_);
+        auto columns = forceMatrix.columns(i);
+        auto values = forceMatrix.values(i);
+        for (size_t n = 0; n != columns.size(); ++n) {
+            int j = columns[n];
+            if (j < i) continue;
+            columns_[pos[i]] = j;
+            weights_[pos[i]++] = values[n];
+            if (j != i) {
+                columns_[pos[j]] = i;
+                weights_[pos[j]++] = values[n];
             }
         }
     }
 
     #ifdef PRINT_DEBUG
-        std::cout << "Num vertices = " << num_vertices(graph_) << std::endl;
-        std::cout << "Num edges = " << num_edges(graph_) << std::endl;
+        std::cout << "Num vertices = " << dim << std::endl;
+        std::cout << "Num edges = " << columns_.size() << std::endl;
     #endif
 }
 
+BoostGraph::Workspace::Workspace(size_t nbVertices, size_t nbEdges)
+ : distance(nbVertices, std::numeric_limits<double>::max()),
+   predecessor(nbVertices),
+   color(nbVertices, white),
+   heapIndex(nbVertices, static_cast<size_t>(-1)),
+   edgeMask(nbEdges, 0)
+{
+    for (size_t i = 0; i != nbVertices; ++i) predecessor[i] = i;
+}
+
 BoostGraph::Path BoostGraph::findShortestPath(size_t from, size_t to) const
 {
-    return dijkstra(from, to, graph_);
+    Workspace workspace(rowOffsets_.size() - 1, columns_.size());
+    Path path;
+    if (!dijkstra(from, to, workspace, path)) throw std::runtime_error("No connection between source and dest.");
+    return path;
 }
 
 BoostGraph::PathList BoostGraph::findKShortestPaths(size_t from, size_t to, size_t num) const
@@ -50,58 +97,64 @@ BoostGraph::PathList BoostGraph::findKShortestPaths(size_t from, size_t to, size
 
     PathList variants;
 
+    int nbThreads = gmx_omp_get_max_threads();
+    // Allocated by the threads on first use, a nested call from a parallel region uses only one
+    std::vector<std::unique_ptr<Workspace>> workspaces(nbThreads);
+
     for (size_t k = 1; k < num; ++k)
     {
         Path const& previousPath = shortestPaths[k-1];
 
         // The spur node ranges from the first node to the next to last node in the previous k-shortest path.
-        for (size_t i = 0; i < previousPath.size() - 1; ++i)
-        {
-              // Spur node is retrieved from the previous k-shortest path, k ��� 1.
-            Vertex spurNode = previousPath[i];
+        int nbSpurNodes = previousPath.size() - 1;
+        PathList totalPaths(nbSpurNodes);
+        std::vector<char> found(nbSpurNodes, 0);
 
-              // The sequence of nodes from the source to the spur node of the previous k-shortest path.
-              Path rootPath(previousPath.begin(), previousPath.begin() + i);
-
-              Graph tmpGraph(graph_);
-
-              for (auto & p : shortestPaths) {
-                   if (rootPath == Path(p.begin(), p.begin() + i)) {
-                       // Remove the links that are part of the previous shortest paths which share the same root path.
-                      //std::cout << "remove edge " << p[i] << "  " << p[i+1] << std::endl;
-                       remove_edge(vertex(p[i], tmpGraph), vertex(p[i+1], tmpGraph), tmpGraph);
-                   }
-              }
+        #pragma omp parallel for num_threads(nbThreads) schedule(dynamic)
+        for (int i = 0; i < nbSpurNodes; ++i)
+        {
+            std::unique_ptr<Workspace>& ptrWorkspace = workspaces[gmx_omp_get_thread_num()];
+            if (!ptrWorkspace) ptrWorkspace.reset(new Workspace(rowOffsets_.size() - 1, columns_.size()));
+            Workspace& workspace = *ptrWorkspace;
 
-            #ifdef PRINT_DEBUG
-                std::cout << "tmp graph after remove_edge" << std::endl;
-                print(tmpGraph);
-            #endif
+            // Spur node is retrieved from the previous k-shortest path, k - 1.
+            Vertex spurNode = previousPath[i];
 
-              // Calculate the spur path from the spur node to the sink.
-              Path spurPath;
-              try {
-                  spurPath = dijkstra(spurNode, to, tmpGraph);
-              } catch ( ... ) {
-                  continue;
-              }
+            // The sequence of nodes from the source to the spur node of the previous k-shortest path.
+            Path rootPath(previousPath.begin(), previousPath.begin() + i);
+
+            // Remove the links that are part of the previous shortest paths which share the same root path.
+            std::vector<long> maskedEdges;
+            for (auto const& p : shortestPaths) {
+                if (p.size() < static_cast<size_t>(i) + 2 or !std::equal(rootPath.begin(), rootPath.end(), p.begin())) continue;
+                for (long e : {edgeIndex(p[i], p[i+1]), edgeIndex(p[i+1], p[i])}) {
+                    if (e != -1 and !workspace.edgeMask[e]) {
+                        workspace.edgeMask[e] = 1;
+                        maskedEdges.push_back(e);
+                    }
+                }
+            }
 
-            #ifdef PRINT_DEBUG
-                std::cout << "spurPath:" << std::endl;
-                print(spurPath);
-            #endif
+            // Calculate the spur path from the spur node to the sink.
+            Path spurPath;
+            if (dijkstra(spurNode, to, workspace, spurPath)) {
+                // Entire path is made up of the root path and spur path.
+                totalPaths[i] = rootPath;
+                totalPaths[i].insert(totalPaths[i].end(), spurPath.begin(), spurPath.end());
+                found[i] = 1;
+            }
 
-              // Entire path is made up of the root path and spur path.
-              Path totalPath = rootPath;
-              totalPath.insert(totalPath.end(), spurPath.begin(), spurPath.end());
+            for (auto e : maskedEdges) workspace.edgeMask[e] = 0;
+        }
 
+        // Add the potential k-shortest paths to the heap in the order of the spur nodes.
+        for (int i = 0; i < nbSpurNodes; ++i) {
+            if (!found[i]) continue;
             #ifdef PRINT_DEBUG
                 std::cout << "totalPath:" << std::endl;
-                print(totalPath);
+                print(totalPaths[i]);
             #endif
-
-              // Add the potential k-shortest path to the heap.
-              variants.push_back(totalPath);
+            variants.push_back(std::move(totalPaths[i]));
         }
 
         // This handles the case of there being no spur paths, or no spur paths left.
@@ -113,12 +166,13 @@ BoostGraph::PathList BoostGraph::findKShortestPaths(size_t from, size_t to, size
         // Find the potential k-shortest path.
         PathList::iterator iterShortestPath;
         double minDistance = std::numeric_limits<double>::max();
-          for (auto iter(variants.begin()), iterEnd(variants.end()); iter != iterEnd;  ++iter) {
-              if (distance(*iter) < minDistance) {
-                  minDistance = distance(*iter);
-                  iterShortestPath = iter;
-              }
-          }
+        for (auto iter(variants.begin()), iterEnd(variants.end()); iter != iterEnd;  ++iter) {
+            double d = distance(*iter);
+            if (d < minDistance) {
+                minDistance = d;
+                iterShortestPath = iter;
+            }
+        }
 
         // Add the lowest cost path becomes the k-shortest path.
         #ifdef PRINT_DEBUG
@@ -135,51 +189,164 @@ BoostGraph::PathList BoostGraph::findKShortestPaths(size_t from, size_t to, size
 double BoostGraph::distance(BoostGraph::Path const& path) const
 {
     double dist = 0.0;
-    for (size_t i = 0; i != path.size() - 1; ++i) dist +=  boost::get(boost::edge_weight, graph_, boost::edge(path[i], path[i+1], graph_).first);
+    for (size_t i = 0; i + 1 < path.size(); ++i) {
+        long e = edgeIndex(path[i], path[i+1]);
+        if (e == -1) gmx_fatal(FARGS, "No edge between %d and %d.", path[i], path[i+1]);
+        dist += weights_[e];
+    }
     return dist;
 }
 
-BoostGraph::Path BoostGraph::dijkstra(Vertex source, Vertex dest, Graph const& graph) const
+bool BoostGraph::dijkstra(Vertex source, Vertex dest, Workspace& w, Path& path) const
 {
-    //std::cout << "dijkstra: source = " << source << ", dest = " << dest << std::endl;
-    //if (vertex(source, graph)) gmx_fatal(FARGS, "Vertex source is not an element of graph.");
-    //if (vertex(dest, graph)) gmx_fatal(FARGS, "Vertex dest is not an element of graph.");
+    int nbVertices = rowOffsets_.size() - 1;
+    if (source < 0 or source >= nbVertices or dest < 0 or dest >= nbVertices) return false;
+
+    // Reset the vertices of the previous run
+    for (auto v : w.touched) {
+        w.distance[v] = std::numeric_limits<double>::max();
+        w.predecessor[v] = v;
+        w.color[v] = white;
+        w.heapIndex[v] = static_cast<size_t>(-1);
+    }
+    w.touched.clear();
+    w.heap.clear();
 
-    std::vector<Vertex> predecessor(num_vertices(graph));
-    std::vector<double> distance(num_vertices(graph));
-    Vertex s = vertex(source, graph);
+    w.distance[source] = 0.0;
+    w.color[source] = gray;
+    w.touched.push_back(source);
+    heapPush(w, source);
 
-    dijkstra_shortest_paths(graph, s, boost::predecessor_map(&predecessor[0]).distance_map(&distance[0]));
+    while (!w.heap.empty())
+    {
+        Vertex u = w.heap[0];
+        heapPop(w);
+
+        // The predecessors of all vertices of the path to dest are final
+        if (u == dest) break;
+
+        double du = w.distance[u];
+        for (size_t e = rowOffsets_[u]; e != rowOffsets_[u + 1]; ++e) {
+            if (w.edgeMask[e]) continue;
+            Vertex v = columns_[e];
+            if (w.color[v] == white) {
+                if (du + weights_[e] < w.distance[v]) {
+                    w.distance[v] = du + weights_[e];
+                    w.predecessor[v] = u;
+                }
+                w.color[v] = gray;
+                w.touched.push_back(v);
+                heapPush(w, v);
+            } else if (w.color[v] == gray) {
+                if (du + weights_[e] < w.distance[v]) {
+                    w.distance[v] = du + weights_[e];
+                    w.predecessor[v] = u;
+                    heapUp(w, w.heapIndex[v]);
+                }
+            }
+        }
+        w.color[u] = black;
+    }
 
     #ifdef PRINT_DEBUG
-        boost::graph_traits<Graph>::vertex_iterator vi, vend;
-        for (boost::tie(vi, vend) = boost::vertices(graph); vi != vend; ++vi) {
-            std::cout << "distance(" << *vi << ") = " << distance[*vi] << ", ";
-            std::cout << "parent(" << *vi << ") = " << predecessor[*vi] << std::endl;
+        for (auto v : w.touched) {
+            std::cout << "distance(" << v << ") = " << w.distance[v] << ", ";
+            std::cout << "parent(" << v << ") = " << w.predecessor[v] << std::endl;
         }
     #endif
 
-    Path shortestPath;
-    Vertex cur = vertex(dest, graph);
-    while (cur != s) {
-        shortestPath.push_back(cur);
-        if (cur == predecessor[cur]) throw std::runtime_error("No connection between source and dest.");
-        cur = predecessor[cur];
+    path.clear();
+    Vertex cur = dest;
+    while (cur != source) {
+        path.push_back(cur);
+        if (cur == w.predecessor[cur]) return false;
+        cur = w.predecessor[cur];
+    }
+    path.push_back(source);
+    std::reverse(path.begin(), path.end());
+    return true;
+}
+
+void BoostGraph::heapPush(Workspace& w, Vertex v) const
+{
+    w.heapIndex[v] = w.heap.size();
+    w.heap.push_back(v);
+    heapUp(w, w.heap.size() - 1);
+}
+
+void BoostGraph::heapPop(Workspace& w) const
+{
+    w.heapIndex[w.heap[0]] = static_cast<size_t>(-1);
+    if (w.heap.size() != 1) {
+        w.heap[0] = w.heap.back();
+        w.heapIndex[w.heap[0]] = 0;
+        w.heap.pop_back();
+        heapDown(w);
+    } else {
+        w.heap.pop_back();
     }
-    shortestPath.push_back(source);
-    std::reverse(shortestPath.begin(), shortestPath.end());
-    return shortestPath;
 }
 
-void BoostGraph::print(Graph const& graph) const
+void BoostGraph::heapUp(Workspace& w, size_t index) const
 {
-    boost::graph_traits<Graph>::vertex_iterator vi, vend;
-    for (boost::tie(vi, vend) = boost::vertices(graph); vi != vend; ++vi) {
-        std::cout << *vi << std::endl;
+    if (index == 0) return;
+    Vertex moving = w.heap[index];
+    double movingDistance = w.distance[moving];
+    while (index != 0) {
+        size_t parent = (index - 1) / arity;
+        Vertex parentVertex = w.heap[parent];
+        if (!(movingDistance < w.distance[parentVertex])) break;
+        w.heap[index] = parentVertex;
+        w.heapIndex[parentVertex] = index;
+        index = parent;
     }
-    boost::graph_traits <Graph>::edge_iterator ei, ei_end;
-    for (boost::tie(ei, ei_end) = edges(graph); ei != ei_end; ++ei) {
-        std::cout << source(*ei, graph) << " -> " << target(*ei, graph) << std::endl;
+    w.heap[index] = moving;
+    w.heapIndex[moving] = index;
+}
+
+void BoostGraph::heapDown(Workspace& w) const
+{
+    if (w.heap.empty()) return;
+    size_t index = 0;
+    size_t heapSize = w.heap.size();
+    double movingDistance = w.distance[w.heap[0]];
+    for (;;) {
+        size_t firstChild = index * arity + 1;
+        if (firstChild >= heapSize) break;
+        size_t nbChildren = std::min(arity, heapSize - firstChild);
+        size_t smallestChild = firstChild;
+        double smallestDistance = w.distance[w.heap[firstChild]];
+        for (size_t c = 1; c < nbChildren; ++c) {
+            double d = w.distance[w.heap[firstChild + c]];
+            if (d < smallestDistance) {
+                smallestChild = firstChild + c;
+                smallestDistance = d;
+            }
+        }
+        if (!(smallestDistance < movingDistance)) break;
+        std::swap(w.heap[index], w.heap[smallestChild]);
+        w.heapIndex[w.heap[index]] = index;
+        w.heapIndex[w.heap[smallestChild]] = smallestChild;
+        index = smallestChild;
+    }
+}
+
+long BoostGraph::edgeIndex(Vertex u, Vertex v) const
+{
+    auto begin = columns_.begin() + rowOffsets_[u];
+    auto end = columns_.begin() + rowOffsets_[u + 1];
+    auto iter = std::lower_bound(begin, end, v);
+    if (iter == end or *iter != v) return -1;
+    return iter - columns_.begin();
+}
+
+void BoostGraph::print() const
+{
+    for (size_t u = 0; u + 1 < rowOffsets_.size(); ++u) {
+        std::cout << u << std::endl;
+        for (size_t e = rowOffsets_[u]; e != rowOffsets_[u + 1]; ++e) {
+            std::cout << u << " -> " << columns_[e] << std::endl;
+        }
     }
 }
 
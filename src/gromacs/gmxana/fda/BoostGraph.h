@@ -8,32 +8,33 @@
 #ifndef BOOSTGRAPH_H_
 #define BOOSTGRAPH_H_
 
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/dijkstra_shortest_paths.hpp>
 #include <iostream>
 #include <vector>
+#include "gromacs/fda/SparseForceMatrix.h"
 
 namespace fda_analysis {
 
 /**
  * Special graph implementation fully compatible to Beifei's R script and the igraph library.
+ *
+ * The undirected graph is stored in compressed sparse row format. Dijkstra visits the vertices
+ * in the same order as boost::dijkstra_shortest_paths with its 4-ary heap, which was used before,
+ * so that paths of equal length are resolved identically. Yen's algorithm masks the removed edges
+ * instead of copying the graph and evaluates the spur paths in parallel.
  */
 class BoostGraph
 {
 public:
 
-    typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::undirectedS,
-        boost::no_property, boost::property<boost::edge_weight_t, double> > Graph;
-    typedef boost::graph_traits<Graph>::vertex_descriptor Vertex;
-    typedef boost::graph_traits<Graph>::edge_descriptor Edge;
+    typedef int Vertex;
 
     typedef std::vector<int> Path;
     typedef std::vector<Path> PathList;
 
     BoostGraph() {}
 
-    //! Build graph by adjacency matrix
-    BoostGraph(std::vector<double> const& forceMatrix);
+    //! Build graph by adjacency matrix, only the upper triangle is used
+    BoostGraph(fda::SparseForceMatrix const& forceMatrix);
 
     //! Use Dijkstra algorithm to find the shortest path.
     Path findShortestPath(size_t source, size_t dest) const;
@@ -46,17 +47,51 @@ public:
 
 private:
 
-    //! Calculate the spur path from source to dest.
-    Path dijkstra(Vertex source, Vertex dest, Graph const& graph) const;
+    //! Buffers of a Dijkstra run, reused for all runs of a thread
+    struct Workspace
+    {
+        Workspace(size_t nbVertices, size_t nbEdges);
+
+        std::vector<double> distance;
+        std::vector<Vertex> predecessor;
+        std::vector<char> color;
+
+        //! 4-ary heap of vertices and the position of each vertex in the heap
+        std::vector<Vertex> heap;
+        std::vector<size_t> heapIndex;
+
+        //! Vertices which must be reset for the next run
+        std::vector<Vertex> touched;
+
+        //! Edges removed for the spur path computation
+        std::vector<char> edgeMask;
+    };
+
+    //! Calculate the path from source to dest, returns false if there is no connection.
+    bool dijkstra(Vertex source, Vertex dest, Workspace& workspace, Path& path) const;
+
+    void heapPush(Workspace& workspace, Vertex v) const;
+
+    void heapPop(Workspace& workspace) const;
+
+    void heapUp(Workspace& workspace, size_t index) const;
+
+    void heapDown(Workspace& workspace) const;
+
+    //! Position of edge (u, v) in columns_ and weights_, -1 if not existing
+    long edgeIndex(Vertex u, Vertex v) const;
 
     //! Print graph for debugging
-    void print(Graph const& graph) const;
+    void print() const;
 
     //! Print path for debugging
     void print(Path const& path) const;
 
     //! Undirected graph connecting atoms or residues weighted by the force between both.
-    Graph graph_;
+    //! Both directions of an edge are stored.
+    std::vector<size_t> rowOffsets_;
+    std::vector<Vertex> columns_;
+    std::vector<double> weights_;
 
 };
 
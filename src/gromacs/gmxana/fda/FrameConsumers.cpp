@@ -0,0 +1,242 @@
+/*
+ * FrameConsumers.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include "BoostGraph.h"
+#include "FrameConsumers.h"
+#include "Graph.h"
+#include "StressView.h"
+#include "gromacs/fileio/filetypes.h"
+#include "gromacs/fileio/pdbio.h"
+#include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/futil.h"
+
+namespace fda_analysis {
+
+void FrameAverage::add(fda::SparseForceMatrix const& forceMatrix)
+{
+    if (nbFrames_ == 0) sum_ = forceMatrix;
+    else sum_ += forceMatrix;
+    ++nbFrames_;
+}
+
+fda::SparseForceMatrix FrameAverage::mean()
+{
+    fda::SparseForceMatrix result;
+    std::swap(result, sum_);
+    if (nbFrames_ > 1) result /= nbFrames_;
+    nbFrames_ = 0;
+    return result;
+}
+
+bool NetworkFrames::selects(int frame) const
+{
+    if (frameType_ == ALL) return true;
+    if (frameType_ == SINGLE) return frame == frameValue_;
+    return frame % frameValue_ == 0;
+}
+
+fda::SparseForceMatrix NetworkFrames::prepare(fda::SparseForceMatrix const& forceMatrix) const
+{
+    fda::SparseForceMatrix result(forceMatrix);
+    result.abs();
+
+    // Convert from kJ/mol/nm into pN
+    if (convert_) result *= 1.66;
+    return result;
+}
+
+bool NetworkFrames::read(FrameReader& reader, FrameReader* readerDiff, int nbParticles, fda::SparseForceMatrix& forceMatrix) const
+{
+    FrameAverage average;
+    int nbFrames = frameType_ == AVERAGE ? frameValue_ : 1;
+    for (int frame = 0; frame != nbFrames; ++frame) {
+        bool found = readerDiff ? reader.next_forcematrix_diff(*readerDiff, forceMatrix, nbParticles)
+                                : reader.next_forcematrix(forceMatrix, nbParticles);
+        if (!found) break;
+        average.add(prepare(forceMatrix));
+    }
+    if (average.size() == 0) return false;
+    forceMatrix = average.mean();
+    return true;
+}
+
+PunctualStressConsumer::PunctualStressConsumer(std::string const& filename)
+ : os_(filename)
+{
+    if (!os_) gmx_fatal(FARGS, "Error opening file %s", filename.c_str());
+    os_ << std::scientific << std::setprecision(6)
+        << "punctual_stress\n";
+}
+
+void PunctualStressConsumer::consume(int /*frame*/, fda::SparseForceMatrix const& forceMatrix, rvec * /*coordinates*/, const matrix /*box*/)
+{
+    for (int i = 0; i < forceMatrix.dim(); ++i) {
+        real stress = 0.0;
+        for (double f : forceMatrix.values(i)) stress += std::abs(f);
+        os_ << stress << " ";
+    }
+    os_ << std::endl;
+}
+
+StressViewConsumer::StressViewConsumer(std::string const& filename, std::string const& title, NetworkFrames const& frames,
+    int frameValue, int nbColors, t_atoms *atoms, PbcType pbcType)
+ : filename_(filename),
+   title_(title),
+   frames_(frames),
+   frameValue_(frameValue),
+   nbColors_(nbColors),
+   atoms_(atoms),
+   pbcType_(pbcType),
+   pdb_(fn2ftp(filename.c_str()) == efPDB),
+   nbWrittenFrames_(0),
+   valueToLargeForPDB_(false)
+{
+    if (!pdb_ and fn2ftp(filename.c_str()) != efXPM) gmx_fatal(FARGS, "Stress view must be a pdb or xpm-file.");
+}
+
+bool StressViewConsumer::needs(int frame) const
+{
+    // The xpm-file is written from the stress of all frames
+    return !pdb_ or frames_.selects(frame);
+}
+
+void StressViewConsumer::consume(int /*frame*/, fda::SparseForceMatrix const& forceMatrix, rvec *coordinates, const matrix box)
+{
+    std::vector<real> stress(forceMatrix.dim(), 0.0);
+    for (int i = 0; i < forceMatrix.dim(); ++i) {
+        for (double f : forceMatrix.values(i)) stress[i] += std::abs(f);
+    }
+    real maxValue = 0.0;
+    for (auto& value : stress) {
+        // Convert from kJ/mol/nm into pN
+        if (frames_.convert()) value *= 1.66;
+        if (value > maxValue) maxValue = value;
+    }
+
+    if (!pdb_) {
+        stress_.push_back(std::move(stress));
+        return;
+    }
+
+    if (static_cast<int>(stress.size()) > atoms_->nr) gmx_fatal(FARGS, "Structure has less atoms than stress values.");
+
+    FILE *fp = gmx_ffopen(filename_.c_str(), nbWrittenFrames_ ? "a" : "w");
+    for (size_t i = 0; i < stress.size(); ++i) {
+        // For a single frame the values are clamped to the b-factor column width
+        if (frames_.frameType() == SINGLE and stress[i] > 999.99) atoms_->pdbinfo[i].bfac = 999.99;
+        else atoms_->pdbinfo[i].bfac = stress[i];
+    }
+    if (maxValue > 999.99) valueToLargeForPDB_ = true;
+
+    write_pdbfile(fp, title_.c_str(), atoms_, coordinates, pbcType_, box, ' ', 0, nullptr);
+    gmx_ffclose(fp);
+    ++nbWrittenFrames_;
+}
+
+void StressViewConsumer::finish()
+{
+    if (!pdb_) {
+        if (stress_.empty()) gmx_fatal(FARGS, "No frames found for the stress view.");
+        writeStressXPM(filename_, title_, stress_, frames_.frameType(), frameValue_, nbColors_);
+    }
+
+    if (valueToLargeForPDB_)
+        gmx_warning("Stress values larger than 999.99 are detected. Therefore, the general PDB format of the b-factor column of Real(6.2) is broken. "
+                    "It is tested that it works for Pymol and VMD, but it is not guaranteed that it will work for other visualization programs.");
+}
+
+GraphConsumer::GraphConsumer(std::string const& filename, NetworkFrames const& frames, real threshold,
+    int minGraphOrder, bool onlyBiggestNetwork, int *index, int isize)
+ : filename_(filename),
+   frames_(frames),
+   threshold_(threshold),
+   minGraphOrder_(minGraphOrder),
+   onlyBiggestNetwork_(onlyBiggestNetwork),
+   index_(index),
+   isize_(isize),
+   dimacs_(fn2ftp(filename.c_str()) == efDIM),
+   nbWrittenFrames_(0)
+{
+    if (dimacs_ and frames_.frameType() != SINGLE) gmx_fatal(FARGS, "DIMACS format is not supported for multiple frames.");
+}
+
+void GraphConsumer::consume(int frame, fda::SparseForceMatrix const& forceMatrix, rvec *coordinates, const matrix /*box*/)
+{
+    if (frames_.frameType() != AVERAGE) {
+        write(frames_.prepare(forceMatrix), coordinates);
+        return;
+    }
+
+    // The network of an interval is drawn with the coordinates of its first frame
+    if (average_.size() == 0) {
+        int nbCoordinates = index_ ? *std::max_element(index_, index_ + isize_) + 1 : forceMatrix.dim();
+        averageCoordinates_.assign(coordinates, coordinates + nbCoordinates);
+    }
+    average_.add(frames_.prepare(forceMatrix));
+    if (frames_.completesAverage(frame)) write(average_.mean(), as_rvec_array(averageCoordinates_.data()));
+}
+
+void GraphConsumer::finish()
+{
+    if (average_.size()) write(average_.mean(), as_rvec_array(averageCoordinates_.data()));
+}
+
+void GraphConsumer::write(fda::SparseForceMatrix const& forceMatrix, rvec *coordinates)
+{
+    Graph graph(forceMatrix, coordinates, index_, isize_);
+
+    if (dimacs_)
+        graph.convertInDIMACSMinGraphOrder(filename_, threshold_, minGraphOrder_, onlyBiggestNetwork_);
+    else
+        graph.convertInPDBMinGraphOrder(filename_, threshold_, minGraphOrder_, onlyBiggestNetwork_, nbWrittenFrames_);
+    ++nbWrittenFrames_;
+}
+
+ShortestPathConsumer::ShortestPathConsumer(std::string const& filename, NetworkFrames const& frames, PDB const& pdb,
+    int source, int dest, int numberOfShortestPaths)
+ : filename_(filename),
+   frames_(frames),
+   pdb_(pdb),
+   source_(source),
+   dest_(dest),
+   numberOfShortestPaths_(numberOfShortestPaths),
+   nbWrittenFrames_(0)
+{}
+
+void ShortestPathConsumer::consume(int frame, fda::SparseForceMatrix const& forceMatrix, rvec *coordinates, const matrix /*box*/)
+{
+    if (frames_.frameType() != AVERAGE) {
+        // For a single frame the coordinates of the structure are kept
+        if (frames_.frameType() != SINGLE) pdb_.updateCoordinates(coordinates);
+        write(frames_.prepare(forceMatrix));
+        return;
+    }
+
+    // The paths of an interval are drawn with the coordinates of its first frame
+    if (average_.size() == 0) pdb_.updateCoordinates(coordinates);
+    average_.add(frames_.prepare(forceMatrix));
+    if (frames_.completesAverage(frame)) write(average_.mean());
+}
+
+void ShortestPathConsumer::finish()
+{
+    if (average_.size()) write(average_.mean());
+}
+
+void ShortestPathConsumer::write(fda::SparseForceMatrix const& forceMatrix)
+{
+    BoostGraph graph(forceMatrix);
+    BoostGraph::PathList shortestPaths = graph.findKShortestPaths(source_, dest_, numberOfShortestPaths_);
+    pdb_.writePaths(filename_, shortestPaths, forceMatrix, nbWrittenFrames_);
+    ++nbWrittenFrames_;
+}
+
+} // namespace fda_analysis
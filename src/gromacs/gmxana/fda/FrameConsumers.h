@@ -0,0 +1,230 @@
+/*
+ * FrameConsumers.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef FRAMECONSUMERS_H_
+#define FRAMECONSUMERS_H_
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "FramePipeline.h"
+#include "FrameType.h"
+#include "PDB.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/topology/atoms.h"
+
+namespace fda_analysis {
+
+/**
+ * Mean of the force matrices of an interval of frames for -frame "average n"
+ */
+class FrameAverage
+{
+public:
+
+    /// Adds a frame of the current interval
+    void add(fda::SparseForceMatrix const& forceMatrix);
+
+    /// Number of frames added to the current interval
+    int size() const { return nbFrames_; }
+
+    /// Mean of the added frames, a short last interval is divided by the number of its frames.
+    /// The next frame starts a new interval.
+    fda::SparseForceMatrix mean();
+
+private:
+
+    fda::SparseForceMatrix sum_;
+
+    int nbFrames_ = 0;
+
+};
+
+/**
+ * Frame selection (-frame) and force preparation (-convert) of the network analyses
+ */
+class NetworkFrames
+{
+public:
+
+    typedef FramePipeline::PairwiseForces::FrameReader FrameReader;
+
+    NetworkFrames(FrameType frameType, int frameValue, bool convert)
+     : frameType_(frameType), frameValue_(frameValue), convert_(convert)
+    {}
+
+    FrameType frameType() const { return frameType_; }
+
+    int frameValue() const { return frameValue_; }
+
+    bool convert() const { return convert_; }
+
+    /// True for the frames which are analyzed, for "average n" the first frame of each interval
+    bool selects(int frame) const;
+
+    /// True for the frames which are read, for "average n" all frames
+    bool reads(int frame) const { return frameType_ == AVERAGE or selects(frame); }
+
+    /// True for the last frame of an interval of "average n"
+    bool completesAverage(int frame) const { return frameType_ == AVERAGE and frame % frameValue_ == frameValue_ - 1; }
+
+    /// Absolute forces, converted into pN if requested, as in gmx_fda_graph and gmx_fda_shortest_path
+    fda::SparseForceMatrix prepare(fda::SparseForceMatrix const& forceMatrix) const;
+
+    /// Reads the next frame with reader, -diff is subtracted if readerDiff is not nullptr, and prepares it.
+    /// For "average n" the mean of the next n frames is returned. Returns false if no frame was left.
+    bool read(FrameReader& reader, FrameReader* readerDiff, int nbParticles, fda::SparseForceMatrix& forceMatrix) const;
+
+private:
+
+    FrameType frameType_;
+
+    int frameValue_;
+
+    bool convert_;
+
+};
+
+/// Punctual stress of all frames, as written by gmx_fda_get_stress
+class PunctualStressConsumer : public FrameConsumer
+{
+public:
+
+    PunctualStressConsumer(std::string const& filename);
+
+    void consume(int frame, fda::SparseForceMatrix const& forceMatrix, rvec *coordinates, const matrix box) override;
+
+private:
+
+    std::ofstream os_;
+
+};
+
+/// Punctual stress as pdb-file of the selected frames or xpm-file, as written by gmx_fda_view_stress
+class StressViewConsumer : public FrameConsumer
+{
+public:
+
+    /// atoms is only needed for pdb-files and must have pdbinfo
+    StressViewConsumer(std::string const& filename, std::string const& title, NetworkFrames const& frames,
+        int frameValue, int nbColors, t_atoms *atoms, PbcType pbcType);
+
+    bool needs(int frame) const override;
+
+    void consume(int frame, fda::SparseForceMatrix const& forceMatrix, rvec *coordinates, const matrix box) override;
+
+    void finish() override;
+
+private:
+
+    std::string filename_;
+
+    std::string title_;
+
+    NetworkFrames frames_;
+
+    int frameValue_;
+
+    int nbColors_;
+
+    t_atoms *atoms_;
+
+    PbcType pbcType_;
+
+    bool pdb_;
+
+    int nbWrittenFrames_;
+
+    bool valueToLargeForPDB_;
+
+    /// Stress of all frames for the xpm-file
+    std::vector<std::vector<real>> stress_;
+
+};
+
+/// Force networks of the selected frames, as written by gmx_fda_graph
+class GraphConsumer : public FrameConsumer
+{
+public:
+
+    GraphConsumer(std::string const& filename, NetworkFrames const& frames, real threshold,
+        int minGraphOrder, bool onlyBiggestNetwork, int *index, int isize);
+
+    bool needs(int frame) const override { return frames_.reads(frame); }
+
+    void consume(int frame, fda::SparseForceMatrix const& forceMatrix, rvec *coordinates, const matrix box) override;
+
+    void finish() override;
+
+private:
+
+    void write(fda::SparseForceMatrix const& forceMatrix, rvec *coordinates);
+
+    std::string filename_;
+
+    NetworkFrames frames_;
+
+    real threshold_;
+
+    int minGraphOrder_;
+
+    bool onlyBiggestNetwork_;
+
+    int *index_;
+
+    int isize_;
+
+    bool dimacs_;
+
+    int nbWrittenFrames_;
+
+    FrameAverage average_;
+
+    /// Coordinates of the first frame of the current interval of "average n"
+    std::vector<gmx::RVec> averageCoordinates_;
+
+};
+
+/// k-shortest paths of the selected frames, as written by gmx_fda_shortest_path
+class ShortestPathConsumer : public FrameConsumer
+{
+public:
+
+    ShortestPathConsumer(std::string const& filename, NetworkFrames const& frames, PDB const& pdb,
+        int source, int dest, int numberOfShortestPaths);
+
+    bool needs(int frame) const override { return frames_.reads(frame); }
+
+    void consume(int frame, fda::SparseForceMatrix const& forceMatrix, rvec *coordinates, const matrix box) override;
+
+    void finish() override;
+
+private:
+
+    void write(fda::SparseForceMatrix const& forceMatrix);
+
+    std::string filename_;
+
+    NetworkFrames frames_;
+
+    PDB pdb_;
+
+    int source_;
+
+    int dest_;
+
+    int numberOfShortestPaths_;
+
+    int nbWrittenFrames_;
+
+    FrameAverage average_;
+
+};
+
+} // namespace fda_analysis
+
+#endif /* FRAMECONSUMERS_H_ */
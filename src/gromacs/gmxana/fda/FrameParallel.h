@@ -0,0 +1,59 @@
+/*
+ * FrameParallel.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef FRAMEPARALLEL_H_
+#define FRAMEPARALLEL_H_
+
+#include <algorithm>
+#include <vector>
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/gmxomp.h"
+
+namespace fda_analysis {
+
+/// Number of frames per thread which are computed before the results are written
+constexpr int framesPerThread = 4;
+
+/**
+ * Frame-parallel driver of the analysis tools
+ *
+ * The frames are computed by a team of OpenMP threads in blocks of framesPerThread frames
+ * per thread. After each block the results are written by the calling thread in the order
+ * of the frames, so the output is identical to a sequential run and the memory is bounded
+ * by the block size.
+ *
+ * compute(frame, result, thread) must only modify the state of its thread, e.g. its own
+ * FrameReader of the shared frame index. write(frame, result) is called in frame order.
+ */
+template <class Result, class Compute, class Write>
+void processFramesInParallel(std::vector<int> const& frames, int nbThreads, Compute compute, Write write)
+{
+    int nbFrames = frames.size();
+    int blockSize = std::max(nbThreads, 1) * framesPerThread;
+    std::vector<Result> results(std::min(blockSize, nbFrames));
+
+    for (int begin = 0; begin < nbFrames; begin += blockSize)
+    {
+        int end = std::min(begin + blockSize, nbFrames);
+
+        #pragma omp parallel for num_threads(nbThreads) schedule(dynamic)
+        for (int n = begin; n < end; ++n)
+        {
+            try
+            {
+                compute(frames[n], results[n - begin], gmx_omp_get_thread_num());
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+        }
+
+        for (int n = begin; n < end; ++n) write(frames[n], results[n - begin]);
+    }
+}
+
+} // namespace fda_analysis
+
+#endif /* FRAMEPARALLEL_H_ */
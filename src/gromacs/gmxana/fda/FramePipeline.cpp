@@ -0,0 +1,70 @@
+/*
+ * FramePipeline.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <algorithm>
+#include "FramePipeline.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/utility/fatalerror.h"
+
+namespace fda_analysis {
+
+FramePipeline::FramePipeline(PairwiseForces const& pairwiseForces, PairwiseForces const* ptrPairwiseForcesDiff, int nbParticles)
+ : pairwiseForces_(pairwiseForces),
+   ptrPairwiseForcesDiff_(ptrPairwiseForcesDiff),
+   nbParticles_(nbParticles)
+{}
+
+void FramePipeline::add(std::unique_ptr<FrameConsumer> consumer)
+{
+    consumers_.push_back(std::move(consumer));
+}
+
+void FramePipeline::run(gmx_output_env_t const* oenv, const char* trajectoryFilename, rvec *coordinates, const matrix box)
+{
+    auto frameReader = pairwiseForces_.get_frame_reader();
+    std::unique_ptr<PairwiseForces::FrameReader> ptrFrameReaderDiff;
+    if (ptrPairwiseForcesDiff_) ptrFrameReaderDiff.reset(new PairwiseForces::FrameReader(*ptrPairwiseForcesDiff_));
+
+    t_trxstatus *status = nullptr;
+    real time;
+    rvec *frameCoordinates = coordinates;
+    matrix frameBox;
+    copy_mat(box, frameBox);
+    if (trajectoryFilename) read_first_x(oenv, &status, trajectoryFilename, &time, &frameCoordinates, frameBox);
+
+    fda::SparseForceMatrix forceMatrix;
+    for (int frame = 0; ; ++frame)
+    {
+        bool needed = std::any_of(consumers_.begin(), consumers_.end(),
+            [frame](std::unique_ptr<FrameConsumer> const& consumer){ return consumer->needs(frame); });
+
+        if (needed) {
+            if (ptrFrameReaderDiff) {
+                if (!frameReader.next_forcematrix_diff(*ptrFrameReaderDiff, forceMatrix, nbParticles_)) break;
+            } else {
+                if (!frameReader.next_forcematrix(forceMatrix, nbParticles_)) break;
+            }
+        } else {
+            if (!frameReader.skip()) break;
+            if (ptrFrameReaderDiff and !ptrFrameReaderDiff->skip()) gmx_fatal(FARGS, "Frame not found.");
+        }
+
+        if (status and frame) read_next_x(oenv, status, &time, frameCoordinates, frameBox);
+        if (!needed) continue;
+
+        for (auto& consumer : consumers_) {
+            if (consumer->needs(frame)) consumer->consume(frame, forceMatrix, frameCoordinates, frameBox);
+        }
+    }
+
+    if (status) close_trx(status);
+
+    for (auto& consumer : consumers_) consumer->finish();
+}
+
+} // namespace fda_analysis
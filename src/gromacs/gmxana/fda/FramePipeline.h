@@ -0,0 +1,77 @@
+/*
+ * FramePipeline.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef FRAMEPIPELINE_H_
+#define FRAMEPIPELINE_H_
+
+#include <memory>
+#include <vector>
+#include "gromacs/fda/PairwiseForces.h"
+#include "gromacs/fda/SparseForceMatrix.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/real.h"
+
+struct gmx_output_env_t;
+
+namespace fda_analysis {
+
+/**
+ * Analysis which is fed with the frames of a FramePipeline
+ */
+class FrameConsumer
+{
+public:
+
+    virtual ~FrameConsumer() {}
+
+    /// Frames which are needed by no consumer are skipped without parsing them
+    virtual bool needs(int /*frame*/) const { return true; }
+
+    /// Called in frame order with the force matrix, -diff is already subtracted,
+    /// and the coordinates of the trajectory frame
+    virtual void consume(int frame, fda::SparseForceMatrix const& forceMatrix, rvec *coordinates, const matrix box) = 0;
+
+    /// Called after the last frame
+    virtual void finish() {}
+
+};
+
+/**
+ * Single streaming pass over the pairwise forces and the trajectory
+ *
+ * Each frame is parsed once and passed together with its coordinates to all consumers,
+ * so that several analyses need only one read of the input files.
+ */
+class FramePipeline
+{
+public:
+
+    typedef fda::PairwiseForces<fda::Force<real>> PairwiseForces;
+
+    /// ptrPairwiseForcesDiff is optional and can be nullptr
+    FramePipeline(PairwiseForces const& pairwiseForces, PairwiseForces const* ptrPairwiseForcesDiff, int nbParticles);
+
+    void add(std::unique_ptr<FrameConsumer> consumer);
+
+    /// Without trajectory (trajectoryFilename is nullptr) the coordinates and box of the structure are used for all frames
+    void run(gmx_output_env_t const* oenv, const char* trajectoryFilename, rvec *coordinates, const matrix box);
+
+private:
+
+    PairwiseForces const& pairwiseForces_;
+
+    PairwiseForces const* ptrPairwiseForcesDiff_;
+
+    int nbParticles_;
+
+    std::vector<std::unique_ptr<FrameConsumer>> consumers_;
+
+};
+
+} // namespace fda_analysis
+
+#endif /* FRAMEPIPELINE_H_ */
@@ -19,43 +19,34 @@
 
 namespace fda_analysis {
 
-Graph::Graph(std::vector<double> const& forceMatrix, rvec *coord, int *index, int isize)
+Graph::Graph(fda::SparseForceMatrix const& forceMatrix, rvec *coord, int *index, int isize)
 {
 	double force;
-	bool addNode1, addNode2;
-	int dim = sqrt(forceMatrix.size());
-	std::vector<int>::iterator iterFind;
+	int dim = forceMatrix.dim();
+	positions_.assign(dim, -1);
 
     for (int i = 0; i < dim; ++i) {
-        for (int j = 0; j < dim; ++j) {
-        	force = forceMatrix[i*dim+j];
-            if (force == 0.0) continue;
+        auto columns = forceMatrix.columns(i);
+        auto values = forceMatrix.values(i);
+        for (size_t n = 0; n != columns.size(); ++n) {
+            int j = columns[n];
+        	force = values[n];
 			Node node1(i), node2(j);
 
-			iterFind = std::find(indices_.begin(), indices_.end(), i);
-			if (iterFind != indices_.end()) {
-				nodes_[std::distance(indices_.begin(), iterFind)].addConnectedNode(j, force);
-				addNode1 = false;
+			if (positions_[i] != -1) {
+				nodes_[positions_[i]].addConnectedNode(j, force);
 			} else {
-				addNode1 = true;
-			}
-
-			iterFind = std::find(indices_.begin(), indices_.end(), j);
-			if (iterFind != indices_.end()) {
-				nodes_[std::distance(indices_.begin(), iterFind)].addConnectedNode(i, force);
-				addNode2 = false;
-			} else {
-				addNode2 = true;
-			}
-
-			if (addNode1) {
 				node1.addConnectedNode(j, force);
+				positions_[i] = nodes_.size();
                 nodes_.push_back(node1);
                 indices_.push_back(i);
 			}
 
-			if (addNode2) {
+			if (positions_[j] != -1) {
+				nodes_[positions_[j]].addConnectedNode(i, force);
+			} else {
 				node2.addConnectedNode(i, force);
+				positions_[j] = nodes_.size();
                 nodes_.push_back(node2);
                 indices_.push_back(j);
 			}
@@ -63,7 +54,8 @@ Graph::Graph(std::vector<double> const& forceMatrix, rvec *coord, int *index, in
     }
     for (int i = 0; i < dim; ++i)
     {
-    	if (std::find(indices_.begin(), indices_.end(), i) == indices_.end()){
+    	if (positions_[i] == -1) {
+			positions_[i] = nodes_.size();
 			nodes_.push_back(Node(i));
 			indices_.push_back(i);
 		}
@@ -74,15 +66,12 @@ Graph::Graph(std::vector<double> const& forceMatrix, rvec *coord, int *index, in
 
 void Graph::updateCoordinates(rvec *coord, int *index, int isize)
 {
-    std::vector<int>::iterator iterFind;
-
     // residue-based
     if (index) {
         for (int i = 0; i != isize; ++i)
         {
-            iterFind = std::find(indices_.begin(), indices_.end(), i);
-            if (iterFind == indices_.end()) continue;
-            int pos = std::distance(indices_.begin(), iterFind);
+            if (i >= static_cast<int>(positions_.size())) continue;
+            int pos = positions_[i];
 
             /// Values will be converted from nm into Angstrom.
             nodes_[pos].x_ = coord[index[i]][0] * 10.0;
@@ -120,65 +109,95 @@ void Graph::convertInDIMACSMinGraphOrder(std::string const& outFilename, double
 void Graph::createNetworkMinGraphOrder(Networks& networks, double threshold, size_t& minGraphOrder,
     bool onlyBiggestNetwork) const
 {
-	int iNetwork = 0;
-	int idNetwork = 0;
+    // Disjoint sets of node indices with path compression and union by size.
+    // The networks are ordered by their creation or last merge and the members
+    // of a network by the time they joined, which is kept as linked list.
+    int dim = positions_.size();
+    std::vector<int> parent(dim, -1);
+    std::vector<int> next(dim, -1);
+    std::vector<int> head(dim), tail(dim), size(dim);
+    std::vector<size_t> order(dim);
+    size_t nbOrders = 0;
+
+    auto find = [&parent](int i) {
+        int root = i;
+        while (parent[root] != root) root = parent[root];
+        while (parent[i] != root) {
+            int p = parent[i];
+            parent[i] = root;
+            i = p;
+        }
+        return root;
+    };
 
-	for (auto node : nodes_)
+    Network mergedNetwork;
+	for (auto const& node : nodes_)
 	{
-		Network mergedNetwork;
-		bool found = false;
-
-		for (auto network : index(networks))
-		{
-			if (std::find(network.value.begin(), network.value.end(), node.index_) != network.value.end()) {
-				mergedNetwork.push_back(network.index);
-				idNetwork = network.index;
-				found = true;
-			}
-		}
-		if (!found) {
-			mergedNetwork.push_back(networks.size());
-			idNetwork = networks.size();
-			networks.push_back(Network(1,node.index_));
+		int idNetwork = node.index_;
+		if (parent[idNetwork] == -1) {
+			parent[idNetwork] = idNetwork;
+			head[idNetwork] = tail[idNetwork] = idNetwork;
+			size[idNetwork] = 1;
+			order[idNetwork] = nbOrders++;
+		} else {
+			idNetwork = find(idNetwork);
 		}
+		mergedNetwork.assign(1, idNetwork);
 
 		bool sup = false;
 		for (auto connectedIndex : index(node.connectedIndicies_)) {
 			if (std::abs(node.forces_[connectedIndex.index]) >= threshold) {
 				sup = true;
-				iNetwork = 0;
-				bool addNew = true;
-				for (auto network : networks) {
-					if (std::find(network.begin(), network.end(), connectedIndex.value) != network.end()) {
-						mergedNetwork.push_back(iNetwork);
-						addNew = false;
-						break;
-					}
-					++iNetwork;
+				int j = connectedIndex.value;
+				if (parent[j] == -1) {
+					parent[j] = idNetwork;
+					next[tail[idNetwork]] = j;
+					tail[idNetwork] = j;
+					++size[idNetwork];
+				} else {
+					mergedNetwork.push_back(find(j));
 				}
-				if (addNew) networks[idNetwork].push_back(connectedIndex.value);
 			}
 		}
 		if (sup) {
-			std::sort(mergedNetwork.begin(), mergedNetwork.end());
+			std::sort(mergedNetwork.begin(), mergedNetwork.end(), [&order](int n1, int n2){ return order[n1] < order[n2]; });
 			mergedNetwork.erase(std::unique(mergedNetwork.begin(), mergedNetwork.end()), mergedNetwork.end());
 			if (mergedNetwork.size() > 1) {
-				int mergeTimes = 0;
-				Network merge;
-				for (auto mergeIndex : mergedNetwork) {
-					Networks::iterator iter = networks.begin() + (mergeIndex - mergeTimes);
-					merge.insert(merge.end(), iter->begin(), iter->end());
-					networks.erase(iter);
-					++mergeTimes;
+				int root = *std::max_element(mergedNetwork.begin(), mergedNetwork.end(), [&size](int n1, int n2){ return size[n1] < size[n2]; });
+				int first = mergedNetwork.front();
+				int last = tail[first];
+				int mergedSize = size[first];
+				for (size_t m = 1; m != mergedNetwork.size(); ++m) {
+					int other = mergedNetwork[m];
+					next[last] = head[other];
+					last = tail[other];
+					mergedSize += size[other];
 				}
-				networks.push_back(merge);
+				head[root] = head[first];
+				tail[root] = last;
+				size[root] = mergedSize;
+				order[root] = nbOrders++;
+				for (auto other : mergedNetwork) if (other != root) parent[other] = root;
 			}
 		}
 	}
 
+	std::vector<int> roots;
+	for (int i = 0; i != dim; ++i) if (parent[i] == i) roots.push_back(i);
+	std::sort(roots.begin(), roots.end(), [&order](int n1, int n2){ return order[n1] < order[n2]; });
+
+	networks.clear();
+	networks.reserve(roots.size());
+	for (auto root : roots) {
+		Network network;
+		network.reserve(size[root]);
+		for (int i = head[root]; i != -1; i = next[i]) network.push_back(i);
+		networks.push_back(std::move(network));
+	}
+
 	if (onlyBiggestNetwork) {
 		size_t count = 0;
-		for (auto network : networks) {
+		for (auto const& network : networks) {
 			if (network.size() > count) count = network.size();
 			if (count > minGraphOrder) minGraphOrder = count;
 		}
@@ -194,40 +213,26 @@ void Graph::convertNetworkToPDB(std::string const& filename, Networks const& net
     if (!pdb) gmx_fatal(FARGS, "Error opening pdb file.");
 
     std::stringstream connections;
-    std::vector< std::pair<int, int> > finishedPairs;
-    std::vector<int>::const_iterator iterFind;
-    Node node, connectedNode;
+    std::set< std::pair<int, int> > finishedPairs;
     int numNetwork = 0;
     int n = 1;
 
     real currentForce;
     bool valueToLargeForPDB = false;
 
-    for (auto network : networks) {
+    for (auto const& network : networks) {
         if (network.size() >= minGraphOrder) {
         	for (auto nodeId : network) {
-        		iterFind = std::find(indices_.begin(), indices_.end(), nodeId);
-        		if (iterFind == indices_.end()) gmx_fatal(FARGS, "Error in insertPDBInfo.");
-                node = nodes_[std::distance(indices_.begin(), iterFind)];
+                Node const& node = nodes_[position(nodeId)];
                 for (auto connectedIndex : index(node.connectedIndicies_)) {
                     if (std::abs(node.forces_[connectedIndex.index]) >= threshold) {
-                        int pos = std::distance(indices_.begin(), std::find(indices_.begin(), indices_.end(), connectedIndex.value));
-                    	connectedNode = nodes_[pos];
-                    	bool add = true;
-                    	for (auto finishedPair : finishedPairs) {
-                    		if ((node.index_ == finishedPair.first and
-                    			 connectedNode.index_ == finishedPair.second) or
-                    			(node.index_ == finishedPair.second and
-                    		     connectedNode.index_ == finishedPair.first))
-                    			add = false;
-                    	}
-                    	if (add) {
+                    	Node const& connectedNode = nodes_[position(connectedIndex.value)];
+                    	if (finishedPairs.insert(std::minmax(node.index_, connectedNode.index_)).second) {
                     	    currentForce = node.forces_[connectedIndex.index];
                     	    if (currentForce > 999.99) valueToLargeForPDB = true;
                     		writeAtomToPDB(pdb, n, node, currentForce, numNetwork);
                     		writeAtomToPDB(pdb, n+1, connectedNode, currentForce, numNetwork);
                             connections << "CONECT" << std::setw(5) << n << std::setw(5) << n+1 << std::endl;
-                            finishedPairs.push_back(std::make_pair(node.index_, connectedNode.index_));
                             n += 2;
                     	}
                     }
@@ -254,31 +259,18 @@ void Graph::convertNetworkToDIMACS(std::string const& outFilename, Networks cons
     std::stringstream edgeSection;
     std::set<int> addedNodes;
     std::map<int, int> corresp;
-    std::vector< std::pair<int, int> > finishedPairs;
-    std::vector<int>::const_iterator iterFind;
-    Node node, connectedNode;
+    std::set< std::pair<int, int> > finishedPairs;
     int numNetwork = 0;
     int n = 1;
 
-    for (auto network : networks) {
+    for (auto const& network : networks) {
         if (network.size() >= minGraphOrder) {
         	for (auto nodeId : network) {
-        		iterFind = std::find(indices_.begin(), indices_.end(), nodeId);
-        		if (iterFind == indices_.end()) gmx_fatal(FARGS, "Error in insertPDBInfo.");
-                node = nodes_[std::distance(indices_.begin(), iterFind)];
+                Node const& node = nodes_[position(nodeId)];
                 for (auto connectedIndex : index(node.connectedIndicies_)) {
                     if (std::abs(node.forces_[connectedIndex.index]) >= threshold) {
-                        int pos = std::distance(indices_.begin(), std::find(indices_.begin(), indices_.end(), connectedIndex.value));
-                    	connectedNode = nodes_[pos];
-                    	bool add = true;
-                    	for (auto finishedPair : finishedPairs) {
-                    		if ((node.index_ == finishedPair.first and
-                    			 connectedNode.index_ == finishedPair.second) or
-                    			(node.index_ == finishedPair.second and
-                    		     connectedNode.index_ == finishedPair.first))
-                    			add = false;
-                    	}
-                    	if (add) {
+                    	Node const& connectedNode = nodes_[position(connectedIndex.value)];
+                    	if (finishedPairs.insert(std::minmax(node.index_, connectedNode.index_)).second) {
                             if (addedNodes.find(node.index_) == addedNodes.end()) {
                             	addedNodes.insert(node.index_);
                             	corresp[node.index_] = n;
@@ -290,7 +282,6 @@ void Graph::convertNetworkToDIMACS(std::string const& outFilename, Networks cons
                             	++n;
                             }
                             edgeSection << "e " << corresp[node.index_] << " " << corresp[connectedNode.index_] << std::endl;
-                            finishedPairs.push_back(std::make_pair(node.index_, connectedNode.index_));
                     	}
                     }
                 }
@@ -304,6 +295,13 @@ void Graph::convertNetworkToDIMACS(std::string const& outFilename, Networks cons
     dimacs << edgeSection.str();
 }
 
+int Graph::position(int nodeIndex) const
+{
+    if (nodeIndex < 0 or nodeIndex >= static_cast<int>(positions_.size()) or positions_[nodeIndex] == -1)
+        gmx_fatal(FARGS, "Error in insertPDBInfo.");
+    return positions_[nodeIndex];
+}
+
 void Graph::writeAtomToPDB(std::ofstream& os, int num, Node const& node, double force,
     int numNetwork) const
 {
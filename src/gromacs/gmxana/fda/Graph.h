@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 
+#include "gromacs/fda/SparseForceMatrix.h"
 #include "gromacs/math/vectypes.h"
 #include "Node.h"
 
@@ -28,7 +29,7 @@ public:
 	Graph() {}
 
 	//! Build graph by adjacency matrix
-	Graph(std::vector<double> const& forceMatrix, rvec *coord, int *index, int isize);
+	Graph(fda::SparseForceMatrix const& forceMatrix, rvec *coord, int *index, int isize);
 
 	void convertInPDBMinGraphOrder(std::string const& outFilename, double threshold,
 		size_t minGraphOrder, bool onlyBiggestNetwork, bool append) const;
@@ -54,12 +55,18 @@ private:
 	void writeAtomToPDB(std::ofstream& os, int num, Node const& node, double force,
         int numNetwork) const;
 
+	//! Position of the node with index nodeIndex in nodes_
+	int position(int nodeIndex) const;
+
 	friend std::ostream& operator << (std::ostream& os, Graph const& graph);
 
 	std::vector<Node> nodes_;
 
 	std::vector<int> indices_;
 
+	//! Position of each node index in nodes_, -1 if not in graph
+	std::vector<int> positions_;
+
     static std::vector<std::string> colors;
 
     /// Flag for printing warning only one time per run.
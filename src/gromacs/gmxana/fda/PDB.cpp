@@ -65,7 +65,7 @@ PDB::PDB(std::string const& pdbFilename, std::vector<int> groupAtoms)
 }
 
 void PDB::writePaths(std::string const& filename, std::vector< std::vector<int> > const& shortestPaths,
-    std::vector<double> const& forceMatrix, bool append) const
+    fda::SparseForceMatrix const& forceMatrix, bool append) const
 {
     std::ofstream pdb;
     if (append) pdb.open(filename, std::ofstream::app);
@@ -75,7 +75,6 @@ void PDB::writePaths(std::string const& filename, std::vector< std::vector<int>
     std::stringstream connections;
     int numAtom = 1;
     int numNetwork = 0;
-	int dim = std::sqrt(forceMatrix.size());
 
     real currentForce;
     bool valueToLargeForPDB = false;
@@ -87,7 +86,7 @@ void PDB::writePaths(std::string const& filename, std::vector< std::vector<int>
 			int i = path[n];
 			int j = path[n+1];
 
-            currentForce = forceMatrix[i*dim+j];
+            currentForce = forceMatrix(i, j);
             if (currentForce > 999.99) valueToLargeForPDB = true;
 
 			writeAtomToPDB(pdb, numAtom, indices_[i], coordinates_[i], currentForce, numNetwork);
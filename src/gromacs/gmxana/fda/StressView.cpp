@@ -0,0 +1,80 @@
+/*
+ * StressView.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include "StressView.h"
+#include "gromacs/fileio/matio.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/smalloc.h"
+
+namespace fda_analysis {
+
+void writeStressXPM(std::string const& filename, std::string const& title,
+    std::vector<std::vector<real>> const& stress, FrameType frameType, int frameValue, int nbColors)
+{
+    int nbFrames = stress.size();
+    int nbParticles = stress[0].size();
+
+    // Reorder stressMatrix for writing xpm
+    real **stressMatrix2 = nullptr;
+    snew(stressMatrix2, nbParticles);
+    real minValue = std::numeric_limits<real>::max();
+    real maxValue = 0;
+    int nbFramesForOutput = 1;
+    if (frameType == SINGLE) {
+        for (int i = 0; i < nbParticles; ++i) {
+            snew(stressMatrix2[i], nbFramesForOutput);
+            real value = stress[frameValue][i];
+            stressMatrix2[i][0] = value;
+            if (value < minValue) minValue = value;
+            if (value > maxValue) maxValue = value;
+        }
+    } else {
+        nbFramesForOutput = ceil(static_cast<real>(nbFrames) / frameValue);
+        for (int i = 0; i < nbParticles; ++i) {
+            snew(stressMatrix2[i], nbFramesForOutput);
+            if (frameType == AVERAGE) {
+                for (int j = 0, js = 0; j < nbFramesForOutput; ++j) {
+                    real value = 0.0;
+                    for (int k = 0; k < frameValue and js < nbFrames; ++k, ++js) value += stress[js][i];
+                    value /= frameValue;
+                    stressMatrix2[i][j] = value;
+                    if (value < minValue) minValue = value;
+                    if (value > maxValue) maxValue = value;
+                }
+            } else {
+                for (int j = 0, js = 0; j < nbFramesForOutput; ++j, js += frameValue) {
+                    real value = stress[js][i];
+                    stressMatrix2[i][j] = value;
+                    if (value < minValue) minValue = value;
+                    if (value > maxValue) maxValue = value;
+                }
+            }
+        }
+    }
+
+    FILE *out = gmx_ffopen(filename.c_str(), "w");
+    t_rgb rlo = {1, 1, 1}, rhi = {0, 0, 0};
+    real *t_x;
+    real *t_y;
+    snew(t_x, nbParticles);
+    snew(t_y, nbFramesForOutput);
+    for (int i = 0; i < nbParticles; ++i) t_x[i] = i;
+    for (int i = 0; i < nbFramesForOutput; ++i) t_y[i] = i;
+    write_xpm(out, 0, title.c_str(), "", "Particle", "Frame", nbParticles, nbFramesForOutput,
+        t_x, t_y, stressMatrix2, minValue, maxValue, rlo, rhi, &nbColors);
+    gmx_ffclose(out);
+
+    for (int i = 0; i < nbParticles; ++i) sfree(stressMatrix2[i]);
+    sfree(stressMatrix2);
+    sfree(t_x);
+    sfree(t_y);
+}
+
+} // namespace fda_analysis
@@ -0,0 +1,28 @@
+/*
+ * StressView.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef STRESSVIEW_H_
+#define STRESSVIEW_H_
+
+#include <string>
+#include <vector>
+#include "FrameType.h"
+#include "gromacs/utility/real.h"
+
+namespace fda_analysis {
+
+/**
+ * Write the stress of the frames as xpm-file. The x-axis represent the particle number
+ * and the y-axis the frame number. For frameType AVERAGE the mean over frameValue frames
+ * and for SKIP and ALL every frameValue-th frame is used.
+ */
+void writeStressXPM(std::string const& filename, std::string const& title,
+    std::vector<std::vector<real>> const& stress, FrameType frameType, int frameValue, int nbColors);
+
+} // namespace fda_analysis
+
+#endif /* STRESSVIEW_H_ */
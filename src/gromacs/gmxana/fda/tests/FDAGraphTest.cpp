@@ -183,6 +183,13 @@ INSTANTIATE_TEST_CASE_P(AllFDAGraphTests, FDAGraphTest, ::testing::Values(
         "C-alpha",
         "result.pdb",
         "FDAGraphTest.ref8.pdb"
+    ),
+    TestDataStructure( // 9, frames 3n of fda_average3.pfa are the means of frames 3n to 3n+2 of fda.pfa
+        "alagly",
+        {"-i", "fda_average3.pfa", "-s", "conf.gro", "-frame", "skip 3", "-t", "1000", "-pymol", "result.pml"},
+        "",
+        "result.pdb",
+        "FDAGraphTest.ref5.pdb"
     )
 ));
 
@@ -0,0 +1,139 @@
+/*
+ * FDAPipelineTest.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+#include "gromacs/gmxana/gmx_ana.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/path.h"
+#include "gromacs/utility/real.h"
+#include "testutils/cmdlinetest.h"
+#include "testutils/stdiohelper.h"
+#include "testutils/testfilemanager.h"
+#include "testutils/TextSplitter.h"
+#include "testutils/LogicallyErrorComparer.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+struct TestDataStructure
+{
+    TestDataStructure(
+        std::string const& testDirectory,
+        std::vector<std::string> const& cmdline,
+        std::string const& groupname,
+        std::vector<std::pair<std::string, std::string>> const& resultsAndReferences
+    )
+     : testDirectory(testDirectory),
+       cmdline(cmdline),
+       groupname(groupname),
+       resultsAndReferences(resultsAndReferences)
+    {}
+
+    std::string testDirectory;
+    std::vector<std::string> cmdline;
+    std::string groupname;
+    std::vector<std::pair<std::string, std::string>> resultsAndReferences;
+};
+
+//! Test fixture for FDA
+struct FDAPipelineTest : public ::testing::WithParamInterface<TestDataStructure>,
+                         public CommandLineTestBase
+{
+    void run(std::string const& test_directory)
+    {
+        std::string cwd = gmx::Path::getWorkingDirectory();
+        std::string dataPath = std::string(fileManager().getInputDataDirectory()) + "/data";
+        std::string testPath = fileManager().getTemporaryFilePath("/" + test_directory);
+
+        std::string cmd = "mkdir -p " + testPath;
+        ASSERT_FALSE(system(cmd.c_str()));
+
+        cmd = "cp -r " + dataPath + "/" + test_directory + "/* " + testPath;
+        ASSERT_FALSE(system(cmd.c_str()));
+
+        gmx_chdir(testPath.c_str());
+
+        ::gmx::test::CommandLine caller;
+        caller.append("gmx_fda fda_pipeline");
+        for (std::vector<std::string>::const_iterator iterCur(GetParam().cmdline.begin()), iterNext(GetParam().cmdline.begin() + 1),
+            iterEnd(GetParam().cmdline.end()); iterCur != iterEnd; ++iterCur, ++iterNext)
+        {
+            if (iterNext == iterEnd or iterNext->substr(0,1) == "-") caller.append(*iterCur);
+            else {
+                caller.addOption(iterCur->c_str(), iterNext->c_str());
+                ++iterCur, ++iterNext;
+            }
+        }
+
+        std::cout << caller.toString() << std::endl;
+
+        if (!GetParam().groupname.empty()) {
+            StdioTestHelper stdioHelper(&fileManager());
+            stdioHelper.redirectStringToStdin((GetParam().groupname + "\n").c_str());
+        }
+
+        ASSERT_FALSE(gmx_fda_pipeline(caller.argc(), caller.argv()));
+
+        const double error_factor = 1.0e4;
+        const bool weight_by_magnitude = false;
+        const bool ignore_sign = true;
+
+        LogicallyEqualComparer<weight_by_magnitude,ignore_sign> comparer(error_factor);
+
+        // Each output of the single pass must match the output of the individual tool
+        for (auto const& resultAndReference : GetParam().resultsAndReferences) {
+            EXPECT_TRUE((equal(TextSplitter(resultAndReference.second), TextSplitter(resultAndReference.first), comparer)))
+                << resultAndReference.first;
+        }
+
+        gmx_chdir(cwd.c_str());
+    }
+};
+
+//! Test body for FDA
+TEST_P(FDAPipelineTest, text)
+{
+    run(GetParam().testDirectory);
+}
+
+TEST_P(FDAPipelineTest, binary)
+{
+    run(GetParam().testDirectory + "_binary");
+}
+
+INSTANTIATE_TEST_CASE_P(AllFDAPipelineTests, FDAPipelineTest, ::testing::Values(
+    TestDataStructure(
+        "glycine_trimer",
+        {"-i", "fda.pfr", "-s", "glycine_trimer.pdb", "-f", "traj.trr", "-n", "index.ndx", "-frame", "all",
+         "-source", "0", "-dest", "2", "-nk", "2",
+         "-ops", "result.psr", "-ovs", "result.xpm", "-ograph", "graph.pdb", "-opath", "paths.pdb"},
+        "C-alpha",
+        {{"result.psr", "punctual_stress_text.psr"},
+         {"result.xpm", "FDAViewStress.ref0.xpm"},
+         {"graph.pdb", "FDAGraphTest.ref6.pdb"},
+         {"paths.pdb", "FDAShortestPathTest.ref3.pdb"}}
+    ),
+    TestDataStructure(
+        "glycine_trimer",
+        {"-i", "fda.pfr", "-s", "glycine_trimer.pdb", "-f", "traj.trr", "-n", "index.ndx", "-frame", "average 3",
+         "-source", "0", "-dest", "2", "-nk", "2", "-opath", "paths.pdb"},
+        "C-alpha",
+        {{"paths.pdb", "FDAShortestPathTest.ref1.pdb"}}
+    )
+));
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -151,6 +151,20 @@ INSTANTIATE_TEST_CASE_P(AllFDAShortestPathTests, FDAShortestPathTest, ::testing:
         "C-alpha",
         "result.pdb",
         "FDAShortestPathTest.ref4.pdb"
+    ),
+    TestDataStructure( // 5, frames 3n of fda_average3.pfr are the means of frames 3n to 3n+2 of fda.pfr
+        "glycine_trimer",
+        {"-i", "fda_average3.pfr", "-s", "glycine_trimer.pdb", "-n", "index.ndx", "-frame", "skip 3", "-source", "0", "-dest", "2", "-nk", "2", "-pymol", "result.pml"},
+        "C-alpha",
+        "result.pdb",
+        "FDAShortestPathTest.ref1.pdb"
+    ),
+    TestDataStructure( // 6
+        "glycine_trimer",
+        {"-i", "fda_average3.pfr", "-s", "glycine_trimer.pdb", "-n", "index.ndx", "-frame", "skip 3", "-source", "0", "-dest", "2", "-nk", "2", "-convert", "-pymol", "result.pml"},
+        "C-alpha",
+        "result.pdb",
+        "FDAShortestPathTest.ref2.pdb"
     )
 ));
 
@@ -0,0 +1,95 @@
+/*
+ * NetworkFramesTest.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <fstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "gromacs/fda/PairwiseForces.h"
+#include "gromacs/gmxana/fda/FrameConsumers.h"
+#include "testutils/cmdlinetest.h"
+#include "testutils/testfilemanager.h"
+
+using namespace fda_analysis;
+
+//! Test fixture for the frame selection of the network analyses
+class NetworkFramesTest : public gmx::test::CommandLineTestBase
+{
+public:
+
+    /// Five frames of three particles, the pair (1, 2) is missing in frame 1
+    std::string write_frames()
+    {
+        std::string filename = fileManager().getTemporaryFilePath("frames.pfr");
+        std::ofstream os(filename);
+        os << "pairwise_forces_scalar\n"
+           << "frame 0\n" << "0 1 -2.0 48\n" << "1 2 4.0 48\n"
+           << "frame 1\n" << "0 1 6.0 48\n"
+           << "frame 2\n" << "0 1 1.0 48\n" << "1 2 -3.0 48\n"
+           << "frame 3\n" << "0 1 5.0 48\n" << "1 2 7.0 48\n"
+           << "frame 4\n" << "0 1 -4.0 48\n" << "1 2 2.0 48\n";
+        return filename;
+    }
+};
+
+TEST_F(NetworkFramesTest, Average)
+{
+    fda::PairwiseForces<fda::Force<real>> pairwise_forces(write_frames());
+    fda::PairwiseForces<fda::Force<real>>::FrameReader reader(pairwise_forces);
+    NetworkFrames frames(AVERAGE, 2, false);
+    fda::SparseForceMatrix forceMatrix;
+
+    // Mean of the absolute forces of frames 0 and 1
+    ASSERT_TRUE(frames.read(reader, nullptr, 3, forceMatrix));
+    EXPECT_DOUBLE_EQ(4.0, forceMatrix(0, 1));
+    EXPECT_DOUBLE_EQ(2.0, forceMatrix(1, 2));
+
+    // Frames 2 and 3
+    ASSERT_TRUE(frames.read(reader, nullptr, 3, forceMatrix));
+    EXPECT_DOUBLE_EQ(3.0, forceMatrix(0, 1));
+    EXPECT_DOUBLE_EQ(5.0, forceMatrix(2, 1));
+
+    // The last interval has only frame 4
+    ASSERT_TRUE(frames.read(reader, nullptr, 3, forceMatrix));
+    EXPECT_DOUBLE_EQ(4.0, forceMatrix(0, 1));
+    EXPECT_DOUBLE_EQ(2.0, forceMatrix(1, 2));
+
+    EXPECT_FALSE(frames.read(reader, nullptr, 3, forceMatrix));
+}
+
+TEST_F(NetworkFramesTest, AverageConvert)
+{
+    fda::PairwiseForces<fda::Force<real>> pairwise_forces(write_frames());
+    fda::PairwiseForces<fda::Force<real>>::FrameReader reader(pairwise_forces);
+    NetworkFrames frames(AVERAGE, 3, true);
+    fda::SparseForceMatrix forceMatrix;
+
+    ASSERT_TRUE(frames.read(reader, nullptr, 3, forceMatrix));
+    EXPECT_NEAR(3.0 * 1.66, forceMatrix(0, 1), 1e-6);
+    EXPECT_NEAR(7.0 / 3.0 * 1.66, forceMatrix(1, 2), 1e-6);
+
+    ASSERT_TRUE(frames.read(reader, nullptr, 3, forceMatrix));
+    EXPECT_NEAR(4.5 * 1.66, forceMatrix(0, 1), 1e-6);
+    EXPECT_NEAR(4.5 * 1.66, forceMatrix(1, 2), 1e-6);
+
+    EXPECT_FALSE(frames.read(reader, nullptr, 3, forceMatrix));
+}
+
+TEST_F(NetworkFramesTest, Skip)
+{
+    fda::PairwiseForces<fda::Force<real>> pairwise_forces(write_frames());
+    fda::PairwiseForces<fda::Force<real>>::FrameReader reader(pairwise_forces);
+    NetworkFrames frames(SKIP, 2, false);
+    fda::SparseForceMatrix forceMatrix;
+
+    // Without averaging a single frame is read
+    ASSERT_TRUE(frames.read(reader, nullptr, 3, forceMatrix));
+    EXPECT_DOUBLE_EQ(2.0, forceMatrix(0, 1));
+    EXPECT_DOUBLE_EQ(4.0, forceMatrix(1, 2));
+    ASSERT_TRUE(frames.read(reader, nullptr, 3, forceMatrix));
+    EXPECT_DOUBLE_EQ(6.0, forceMatrix(0, 1));
+    EXPECT_DOUBLE_EQ(0.0, forceMatrix(1, 2));
+}
@@ -181,5 +181,7 @@ int gmx_fda_shortest_path(int argc, char *argv[]);
 
 int gmx_fda_convert(int argc, char *argv[]);
 
+int gmx_fda_pipeline(int argc, char *argv[]);
+
 #endif
 /* _gmx_ana_h */
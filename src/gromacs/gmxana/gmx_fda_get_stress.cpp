@@ -10,10 +10,13 @@
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <memory>
+#include <numeric>
 #include <string>
 #include <sstream>
 #include <cstddef>
 #include <vector>
+#include "fda/FrameParallel.h"
 #include "fda/Graph.h"
 #include "fda/Helpers.h"
 #include "gmx_ana.h"
@@ -27,6 +30,7 @@
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/real.h"
 #include "gromacs/utility/smalloc.h"
 
@@ -47,6 +51,11 @@ int gmx_fda_get_stress(int argc, char *argv[])
     };
 
     gmx_output_env_t *oenv;
+    int nbThreads = gmx_omp_get_max_threads();
+
+    t_pargs pa[] = {
+        { "-nt", FALSE, etINT, {&nbThreads}, "Number of threads to process the frames in parallel" }
+    };
 
     t_filenm fnm[] = {
         { efPFX, "-i", nullptr, ffREAD },
@@ -57,7 +66,9 @@ int gmx_fda_get_stress(int argc, char *argv[])
 #define NFILE asize(fnm)
 
     if (!parse_common_args(&argc, argv, PCA_CAN_TIME,
-        NFILE, fnm, 0, nullptr, asize(desc), desc, 0, nullptr, &oenv)) return 0;
+        NFILE, fnm, asize(pa), pa, asize(desc), desc, 0, nullptr, &oenv)) return 0;
+
+    if (nbThreads < 1) gmx_fatal(FARGS, "Number of threads must be positive.");
 
     // Open pairwise forces file
     fda::PairwiseForces<fda::Force<real>> pairwise_forces(opt2fn("-i", NFILE, fnm));
@@ -65,7 +76,6 @@ int gmx_fda_get_stress(int argc, char *argv[])
 
     size_t nbFrames = pairwise_forces.get_number_of_frames();
     size_t nbParticles = pairwise_forces.get_max_index_second_column_first_frame() + 1;
-    size_t nbParticles2 = nbParticles * nbParticles;
 
     if (opt2bSet("-diff", NFILE, fnm) and (fn2ftp(opt2fn("-diff", NFILE, fnm)) != fn2ftp(opt2fn("-i", NFILE, fnm))))
         gmx_fatal(FARGS, "Type of the file (-diff) does not match the type of the file (-i).");
@@ -86,22 +96,45 @@ int gmx_fda_get_stress(int argc, char *argv[])
     opsFile << std::scientific << std::setprecision(6)
             << "punctual_stress\n";
 
-    for (size_t frame = 0; frame != nbFrames; ++frame)
-    {
-        std::vector<double> forceMatrix = pairwise_forces.get_forcematrix_of_frame(nbParticles, frame);
-        if (opt2bSet("-diff", NFILE, fnm)) {
-            std::vector<double> forceMatrix2 = pairwise_forces_diff.get_forcematrix_of_frame(nbParticles, frame);
-            for (size_t i = 0; i < nbParticles2; ++i) forceMatrix[i] -= forceMatrix2[i];
-        }
-
-        for (size_t i = 0; i < nbParticles; ++i) {
-        real value = 0.0;
-            for (size_t j = 0; j < nbParticles; ++j) value += std::abs(forceMatrix[i*nbParticles + j]);
-            opsFile << value << " ";
-        }
-        opsFile << std::endl;
+    // Each thread reads its frames with its own reader using the shared frame index
+    typedef fda::PairwiseForces<fda::Force<real>>::FrameReader FrameReader;
+    auto frameIndex = pairwise_forces.get_frame_index();
+    decltype(frameIndex) frameIndexDiff;
+    if (opt2bSet("-diff", NFILE, fnm)) frameIndexDiff = pairwise_forces_diff.get_frame_index();
+
+    std::vector<std::unique_ptr<FrameReader>> frameReaders(nbThreads), frameReadersDiff(nbThreads);
+    std::vector<fda::SparseForceMatrix> forceMatrices(nbThreads);
+    for (int thread = 0; thread != nbThreads; ++thread) {
+        frameReaders[thread].reset(new FrameReader(pairwise_forces));
+        if (opt2bSet("-diff", NFILE, fnm)) frameReadersDiff[thread].reset(new FrameReader(pairwise_forces_diff));
     }
 
+    std::vector<int> frames(nbFrames);
+    std::iota(frames.begin(), frames.end(), 0);
+
+    processFramesInParallel<std::vector<real>>(frames, nbThreads,
+        [&](int frame, std::vector<real>& stress, int thread)
+        {
+            fda::SparseForceMatrix& forceMatrix = forceMatrices[thread];
+            frameReaders[thread]->seek(frame, frameIndex);
+            if (frameReadersDiff[thread]) {
+                frameReadersDiff[thread]->seek(frame, frameIndexDiff);
+                if (!frameReaders[thread]->next_forcematrix_diff(*frameReadersDiff[thread], forceMatrix, nbParticles)) gmx_fatal(FARGS, "Frame not found.");
+            } else {
+                if (!frameReaders[thread]->next_forcematrix(forceMatrix, nbParticles)) gmx_fatal(FARGS, "Frame not found.");
+            }
+
+            stress.assign(nbParticles, 0.0);
+            for (size_t i = 0; i < nbParticles; ++i) {
+                for (double f : forceMatrix.values(i)) stress[i] += std::abs(f);
+            }
+        },
+        [&](int /*frame*/, std::vector<real> const& stress)
+        {
+            for (auto value : stress) opsFile << value << " ";
+            opsFile << std::endl;
+        });
+
     std::cout << "All done." << std::endl;
     return 0;
 
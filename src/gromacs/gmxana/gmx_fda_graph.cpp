@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 #include "fda/EnumParser.h"
+#include "fda/FrameConsumers.h"
 #include "fda/FrameType.h"
 #include "fda/Graph.h"
 #include "fda/Helpers.h"
@@ -103,11 +104,12 @@ int gmx_fda_graph(int argc, char *argv[])
     std::shared_ptr<fda::PairwiseForces<fda::Force<real>>> ptr_pairwise_forces_diff;
     if (opt2bSet("-diff", NFILE, fnm)) {
     	ptr_pairwise_forces_diff = std::make_shared<fda::PairwiseForces<fda::Force<real>>>(opt2fn("-diff", NFILE, fnm));
+        if (ptr_pairwise_forces_diff->get_number_of_frames() != pairwise_forces.get_number_of_frames())
+            gmx_fatal(FARGS, "Number of frames is not identical between the two pairwise force files.");
     }
 
     // Get number of particles
     int nbParticles = pairwise_forces.get_max_index_second_column_first_frame() + 1;
-    int nbParticles2 = nbParticles * nbParticles;
 
     // Interactive input of group name for residue model points
     int isize = 0;
@@ -148,7 +150,7 @@ int gmx_fda_graph(int argc, char *argv[])
     matrix box;
     read_tps_conf(ftp2fn(efTPS, NFILE, fnm), &top, &ePBC, &coord, nullptr, box, TRUE);
 
-    std::vector<double> forceMatrix, forceMatrix2;
+    fda::SparseForceMatrix forceMatrix;
 
     // Pymol pml-file
     std::string molecularTrajectoryFilename = "traj.pdb";
@@ -167,16 +169,14 @@ int gmx_fda_graph(int argc, char *argv[])
 
     if (frameType == SINGLE) {
 
-        forceMatrix = pairwise_forces.get_forcematrix_of_frame(nbParticles, frameValue);
-        if (opt2bSet("-diff", NFILE, fnm)) {
-            forceMatrix2 = ptr_pairwise_forces_diff->get_forcematrix_of_frame(nbParticles, frameValue);
-        }
-
-        if (opt2bSet("-diff", NFILE, fnm)) for (int i = 0; i < nbParticles2; ++i) forceMatrix[i] -= forceMatrix2[i];
-        for (auto & f : forceMatrix) f = std::abs(f);
+        if (opt2bSet("-diff", NFILE, fnm))
+            forceMatrix = pairwise_forces.get_sparse_forcematrix_diff_of_frame(*ptr_pairwise_forces_diff, nbParticles, frameValue);
+        else
+            forceMatrix = pairwise_forces.get_sparse_forcematrix_of_frame(nbParticles, frameValue);
+        forceMatrix.abs();
 
         // Convert from kJ/mol/nm into pN
-        if (convert) for (auto & f : forceMatrix) f *= 1.66;
+        if (convert) forceMatrix *= 1.66;
 
         std::cout << "isize " << isize << std::endl;
         std::cout << "index ";
@@ -203,42 +203,29 @@ int gmx_fda_graph(int argc, char *argv[])
         matrix box;
 
         int nbFrames = pairwise_forces.get_number_of_frames();
+
+        NetworkFrames networkFrames(frameType, frameValue, convert);
+
+        // Frames are read in order, each frame is parsed only once
+        auto frameReader = pairwise_forces.get_frame_reader();
+        std::unique_ptr<fda::PairwiseForces<fda::Force<real>>::FrameReader> ptr_frame_reader_diff;
+        if (ptr_pairwise_forces_diff) {
+            ptr_frame_reader_diff.reset(new fda::PairwiseForces<fda::Force<real>>::FrameReader(*ptr_pairwise_forces_diff));
+        }
+
         for (int frame = 0; frame < nbFrames; ++frame)
         {
             if (frame == 0) read_first_x(oenv, &status, opt2fn("-f", NFILE, fnm), &time, &coord_traj, box);
             else read_next_x(oenv, status, &time, coord_traj, box);
 
-            if (frameType == SKIP and frame%frameValue) continue;
-
-            forceMatrix = pairwise_forces.get_forcematrix_of_frame(nbParticles, frame);
-            if (opt2bSet("-diff", NFILE, fnm)) {
-                forceMatrix2 = ptr_pairwise_forces_diff->get_forcematrix_of_frame(nbParticles, frame);
-                for (int i = 0; i < nbParticles2; ++i) forceMatrix[i] -= forceMatrix2[i];
+            if (frameType == SKIP and frame%frameValue) {
+                frameReader.skip();
+                if (ptr_frame_reader_diff) ptr_frame_reader_diff->skip();
+                continue;
             }
-            for (auto & f : forceMatrix) f = std::abs(f);
 
-            // Convert from kJ/mol/nm into pN
-            if (convert) for (auto & f : forceMatrix) f *= 1.66;
-
-            if (frameType == AVERAGE) {
-                for (int frameAvg = 0; frameAvg < frameValue - 1; ++frameAvg)
-                {
-                    std::vector<double> forceMatrixAvg, forceMatrixAvg2;
-                    forceMatrixAvg = pairwise_forces.get_forcematrix_of_frame(nbParticles, frame);
-                    if (opt2bSet("-diff", NFILE, fnm)) {
-                        forceMatrixAvg2 = ptr_pairwise_forces_diff->get_forcematrix_of_frame(nbParticles, frame);
-                        for (int i = 0; i < nbParticles2; ++i) forceMatrixAvg[i] -= forceMatrixAvg2[i];
-                    }
-
-                    for (auto & f : forceMatrixAvg) f = std::abs(f);
-
-                    // Convert from kJ/mol/nm into pN
-                    if (convert) for (auto & f : forceMatrixAvg) f *= 1.66;
-
-                    for (int i = 0; i < nbParticles2; ++i) forceMatrix[i] += forceMatrixAvg[i];
-                }
-                for (int i = 0; i < nbParticles2; ++i) forceMatrix[i] /= frameValue;
-            }
+            // For "average n" the mean of the next n frames is read
+            if (!networkFrames.read(frameReader, ptr_frame_reader_diff.get(), nbParticles, forceMatrix)) gmx_fatal(FARGS, "Frame not found.");
 
             Graph graph(forceMatrix, coord_traj, index, isize);
             graph.convertInPDBMinGraphOrder(opt2fn("-o", NFILE, fnm), threshold, minGraphOrder, onlyBiggestNetwork, frame);
@@ -247,9 +234,9 @@ int gmx_fda_graph(int argc, char *argv[])
             if (opt2bSet("-pymol", NFILE, fnm))
                 write_pdbfile(molecularTrajectoryFile, "FDA trajectory for Pymol visualization", &top.atoms, coord_traj, ePBC, box, ' ', 0, nullptr);
 
+            // The network of an interval is drawn with the coordinates of its first frame
             if (frameType == AVERAGE) {
                 frame += frameValue - 1;
-                // It would be better to skip the next frameValue - 1 frames instead of reading them.
                 for (int frameAvg = 0; frameAvg < frameValue - 1; ++frameAvg) {
                     read_next_x(oenv, status, &time, coord_traj, box);
                 }
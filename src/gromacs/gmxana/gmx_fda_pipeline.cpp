@@ -0,0 +1,191 @@
+/*
+ * gmx_fda_pipeline.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "fda/EnumParser.h"
+#include "fda/FrameConsumers.h"
+#include "fda/FramePipeline.h"
+#include "fda/FrameType.h"
+#include "fda/Helpers.h"
+#include "fda/PDB.h"
+#include "gmx_ana.h"
+#include "gromacs/commandline/filenm.h"
+#include "gromacs/commandline/pargs.h"
+#include "gromacs/fda/PairwiseForces.h"
+#include "gromacs/fileio/confio.h"
+#include "gromacs/fileio/oenv.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/topology/index.h"
+#include "gromacs/topology/topology.h"
+#include "gromacs/utility/arraysize.h"
+#include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/real.h"
+
+#ifdef HAVE_CONFIG_H
+  #include <config.h>
+#endif
+
+using namespace fda_analysis;
+
+#define PRINT_DEBUG
+
+int gmx_fda_pipeline(int argc, char *argv[])
+{
+    const char *desc[] = {
+        "[THISMODULE] runs several FDA analyses in a single pass over the pairwise forces "
+        "and the trajectory. Each frame is read only once and shared by all requested outputs: "
+        "the punctual stress [TT]-ops[tt] as written by [TT]gmx fda_get_stress[tt], "
+        "the stress view [TT]-ovs[tt] as written by [TT]gmx fda_view_stress[tt], "
+        "the force network [TT]-ograph[tt] as written by [TT]gmx fda_graph[tt] and "
+        "the k-shortest paths [TT]-opath[tt] as written by [TT]gmx fda_shortest_path[tt]. "
+        "At least one output must be set. "
+        "If the optional file [TT]-diff[tt] is used the differences of the pairwise forces will be taken. "
+        "The options [TT]-frame[tt] and [TT]-convert[tt] apply to all outputs except the punctual stress, "
+        "which is always written for all frames in kJ/mol/nm."
+    };
+
+    gmx_output_env_t *oenv;
+    const char* frameString = "average 1";
+    real threshold = 0.0;
+    int minGraphOrder = 2;
+    bool onlyBiggestNetwork = false;
+    int source = 0;
+    int dest = 0;
+    int numberOfShortestPaths = 1;
+    bool convert = false;
+    int nbColors = 10;
+
+    t_pargs pa[] = {
+        { "-frame", FALSE, etSTR, {&frameString}, "Specify a single frame number or \"average n\" to take the mean over every n-th frame"
+              " or \"skip n\" to take every n-th frame or \"all\" to take all frames (e.g. for movies)" },
+        { "-t", FALSE, etREAL, {&threshold}, "Threshold for neglecting forces lower than this value (-ograph)" },
+        { "-min", FALSE, etINT, {&minGraphOrder}, "Minimal size of the networks (-ograph)" },
+        { "-big", FALSE, etBOOL, {&onlyBiggestNetwork}, "If True, export only the biggest network (-ograph)" },
+        { "-source", FALSE, etINT, {&source}, "Source node of the path (-opath)" },
+        { "-dest", FALSE, etINT, {&dest}, "Destination point of the path (-opath)" },
+        { "-nk", FALSE, etINT, {&numberOfShortestPaths}, "Number of shortest paths (-opath)" },
+        { "-convert", FALSE, etBOOL, {&convert}, "Convert force unit from kJ/mol/nm into pN" },
+        { "-nbColors", FALSE, etINT, {&nbColors}, "Number of colors for xpm-files (-ovs)" }
+    };
+
+    t_filenm fnm[] = {
+        { efPFX, "-i", nullptr, ffREAD },
+        { efPFX, "-diff", nullptr, ffOPTRD },
+        { efTPS, nullptr, nullptr, ffOPTRD },
+        { efTRX, "-f", nullptr, ffOPTRD },
+        { efNDX, nullptr, nullptr, ffOPTRD },
+        { efPSX, "-ops", "stress", ffOPTWR },
+        { efVST, "-ovs", "stress_view", ffOPTWR },
+        { efGRX, "-ograph", "graph", ffOPTWR },
+        { efPDB, "-opath", "paths", ffOPTWR }
+    };
+
+#define NFILE asize(fnm)
+
+    if (!parse_common_args(&argc, argv, PCA_CAN_TIME,
+        NFILE, fnm, asize(pa), pa, asize(desc), desc, 0, nullptr, &oenv)) return 0;
+
+    bool stressOutput = opt2bSet("-ops", NFILE, fnm);
+    bool stressViewOutput = opt2bSet("-ovs", NFILE, fnm);
+    bool graphOutput = opt2bSet("-ograph", NFILE, fnm);
+    bool pathOutput = opt2bSet("-opath", NFILE, fnm);
+
+    if (!stressOutput and !stressViewOutput and !graphOutput and !pathOutput)
+        gmx_fatal(FARGS, "At least one output (-ops, -ovs, -ograph or -opath) must be set.");
+
+    if (opt2bSet("-diff", NFILE, fnm) and (fn2ftp(opt2fn("-diff", NFILE, fnm)) != fn2ftp(opt2fn("-i", NFILE, fnm))))
+        gmx_fatal(FARGS, "Type of the file (-diff) does not match the type of the file (-i).");
+
+    bool residueBased = fn2ftp(opt2fn("-i", NFILE, fnm)) == efPFR;
+    if (((residueBased and graphOutput) or pathOutput) and !opt2bSet("-n", NFILE, fnm))
+        gmx_fatal(FARGS, "Index file is needed for residuebased pairwise forces and for -opath.");
+
+    bool pdbStressView = stressViewOutput and fn2ftp(opt2fn("-ovs", NFILE, fnm)) == efPDB;
+    if ((graphOutput or pathOutput or pdbStressView) and !ftp2bSet(efTPS, NFILE, fnm))
+        gmx_fatal(FARGS, "Input structure is missing.");
+
+    // Open pairwise forces file
+    fda::PairwiseForces<fda::Force<real>> pairwise_forces(opt2fn("-i", NFILE, fnm));
+    std::unique_ptr<fda::PairwiseForces<fda::Force<real>>> ptr_pairwise_forces_diff;
+    if (opt2bSet("-diff", NFILE, fnm)) {
+        ptr_pairwise_forces_diff.reset(new fda::PairwiseForces<fda::Force<real>>(opt2fn("-diff", NFILE, fnm)));
+        if (ptr_pairwise_forces_diff->get_number_of_frames() != pairwise_forces.get_number_of_frames())
+            gmx_fatal(FARGS, "Number of frames is not identical between the two pairwise force files.");
+    }
+
+    // Get number of particles
+    int nbParticles = pairwise_forces.get_max_index_second_column_first_frame() + 1;
+
+    int frameValue;
+    FrameType frameType = getFrameTypeAndSkipValue(frameString, frameValue);
+    if (frameType != SINGLE and frameValue < 1) gmx_fatal(FARGS, "Frame interval must be positive.");
+
+    // Interactive input of group name for residue model points
+    int isize = 0;
+    int *index = nullptr;
+    char *grpname;
+    if ((graphOutput or pathOutput) and ftp2bSet(efNDX, NFILE, fnm)) {
+        fprintf(stderr, "\nSelect group for residue model points:\n");
+        rd_index(ftp2fn(efNDX, NFILE, fnm), 1, &isize, &index, &grpname);
+    }
+
+    #ifdef PRINT_DEBUG
+        std::cerr << "frameType = " << EnumParser<FrameType>()(frameType) << std::endl;
+        std::cerr << "frameValue = " << frameValue << std::endl;
+        std::cerr << "Number of particles (np) = " << nbParticles << std::endl;
+        std::cerr << "convert = " << convert << std::endl;
+        std::cerr << "pfx filename = " << opt2fn("-i", NFILE, fnm) << std::endl;
+        if (opt2bSet("-diff", NFILE, fnm)) std::cerr << "pfx-diff filename = " << opt2fn("-diff", NFILE, fnm) << std::endl;
+        if (stressOutput) std::cerr << "stress filename = " << opt2fn("-ops", NFILE, fnm) << std::endl;
+        if (stressViewOutput) std::cerr << "stress view filename = " << opt2fn("-ovs", NFILE, fnm) << std::endl;
+        if (graphOutput) std::cerr << "graph filename = " << opt2fn("-ograph", NFILE, fnm) << std::endl;
+        if (pathOutput) std::cerr << "paths filename = " << opt2fn("-opath", NFILE, fnm) << std::endl;
+    #endif
+
+    // Read input structure coordinates
+    rvec *coord = nullptr;
+    t_topology top;
+    PbcType ePBC = PbcType::Unset;
+    matrix box = {{0}};
+    bool structure = ftp2bSet(efTPS, NFILE, fnm);
+    if (structure) read_tps_conf(ftp2fn(efTPS, NFILE, fnm), &top, &ePBC, &coord, nullptr, box, TRUE);
+
+    NetworkFrames networkFrames(frameType, frameValue, convert);
+
+    FramePipeline pipeline(pairwise_forces, ptr_pairwise_forces_diff.get(), nbParticles);
+
+    if (stressOutput)
+        pipeline.add(std::unique_ptr<FrameConsumer>(new PunctualStressConsumer(opt2fn("-ops", NFILE, fnm))));
+
+    if (stressViewOutput) {
+        std::string title = std::string("Punctual stress") + (residueBased ? " over residues" : " over atoms");
+        pipeline.add(std::unique_ptr<FrameConsumer>(new StressViewConsumer(opt2fn("-ovs", NFILE, fnm), title,
+            networkFrames, frameValue, nbColors, structure ? &top.atoms : nullptr, ePBC)));
+    }
+
+    if (graphOutput)
+        pipeline.add(std::unique_ptr<FrameConsumer>(new GraphConsumer(opt2fn("-ograph", NFILE, fnm), networkFrames,
+            threshold, minGraphOrder, onlyBiggestNetwork, index, isize)));
+
+    if (pathOutput)
+        pipeline.add(std::unique_ptr<FrameConsumer>(new ShortestPathConsumer(opt2fn("-opath", NFILE, fnm), networkFrames,
+            PDB(ftp2fn(efTPS, NFILE, fnm), std::vector<int>(index, index + isize)), source, dest, numberOfShortestPaths)));
+
+    // A single frame uses the coordinates of the structure, as the individual tools do
+    const char* trajectoryFilename = nullptr;
+    if (frameType != SINGLE and (graphOutput or pathOutput or pdbStressView)) trajectoryFilename = opt2fn("-f", NFILE, fnm);
+
+    pipeline.run(oenv, trajectoryFilename, coord, box);
+
+    std::cout << "All done." << std::endl;
+    return 0;
+
+}
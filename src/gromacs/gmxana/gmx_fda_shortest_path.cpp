@@ -10,10 +10,13 @@
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 #include "fda/BoostGraph.h"
 #include "fda/EnumParser.h"
+#include "fda/FrameConsumers.h"
+#include "fda/FrameParallel.h"
 #include "fda/FrameType.h"
 #include "fda/Helpers.h"
 #include "fda/PDB.h"
@@ -32,6 +35,7 @@
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/real.h"
 
 #ifdef HAVE_CONFIG_H
@@ -64,6 +68,7 @@ int gmx_fda_shortest_path(int argc, char *argv[])
     int dest = 0;
     int numberOfShortestPaths = 1;
     bool convert = false;
+    int nbThreads = gmx_omp_get_max_threads();
 
     t_pargs pa[] = {
         { "-frame", FALSE, etSTR, {&frameString}, "Specify a single frame number or \"average n\" to take the mean over every n-th frame"
@@ -71,7 +76,8 @@ int gmx_fda_shortest_path(int argc, char *argv[])
         { "-source", FALSE, etINT, {&source}, "Source node of the path" },
         { "-dest", FALSE, etINT, {&dest}, "Destination point of the path" },
         { "-nk", FALSE, etINT, {&numberOfShortestPaths}, "Number of shortest paths" },
-        { "-convert", FALSE, etBOOL, {&convert}, "Convert force unit from kJ/mol/nm into pN" }
+        { "-convert", FALSE, etBOOL, {&convert}, "Convert force unit from kJ/mol/nm into pN" },
+        { "-nt", FALSE, etINT, {&nbThreads}, "Number of threads to process the frames in parallel" }
     };
 
     t_filenm fnm[] = {
@@ -89,6 +95,8 @@ int gmx_fda_shortest_path(int argc, char *argv[])
     if (!parse_common_args(&argc, argv, PCA_CAN_TIME,
         NFILE, fnm, asize(pa), pa, asize(desc), desc, 0, nullptr, &oenv)) return 0;
 
+    if (nbThreads < 1) gmx_fatal(FARGS, "Number of threads must be positive.");
+
     if (opt2bSet("-diff", NFILE, fnm) and (fn2ftp(opt2fn("-diff", NFILE, fnm)) != fn2ftp(opt2fn("-i", NFILE, fnm))))
         gmx_fatal(FARGS, "Type of the file (-diff) does not match the type of the file (-i).");
 
@@ -100,11 +108,12 @@ int gmx_fda_shortest_path(int argc, char *argv[])
     std::shared_ptr<fda::PairwiseForces<fda::Force<real>>> ptr_pairwise_forces_diff;
     if (opt2bSet("-diff", NFILE, fnm)) {
     	ptr_pairwise_forces_diff = std::make_shared<fda::PairwiseForces<fda::Force<real>>>(opt2fn("-diff", NFILE, fnm));
+        if (ptr_pairwise_forces_diff->get_number_of_frames() != pairwise_forces.get_number_of_frames())
+            gmx_fatal(FARGS, "Number of frames is not identical between the two pairwise force files.");
     }
 
     // Get number of particles
     int nbParticles = pairwise_forces.get_max_index_second_column_first_frame() + 1;
-    int nbParticles2 = nbParticles * nbParticles;
 
     // Interactive input of group name for residue model points
     int isize = 0;
@@ -140,7 +149,7 @@ int gmx_fda_shortest_path(int argc, char *argv[])
 
     PDB pdb(opt2fn("-s", NFILE, fnm), std::vector<int>(index, index + isize));
 
-    std::vector<double> forceMatrix, forceMatrix2;
+    fda::SparseForceMatrix forceMatrix;
 
     // Pymol pml-file
     std::string molecularTrajectoryFilename = "traj.pdb";
@@ -165,16 +174,15 @@ int gmx_fda_shortest_path(int argc, char *argv[])
     if (frameType == SINGLE) {
 
         int frame = atoi(frameString);
-        forceMatrix = pairwise_forces.get_forcematrix_of_frame(nbParticles, frame);
-        if (opt2bSet("-diff", NFILE, fnm)) {
-            forceMatrix2 = ptr_pairwise_forces_diff->get_forcematrix_of_frame(nbParticles, frame);
-            for (int i = 0; i < nbParticles2; ++i) forceMatrix[i] -= forceMatrix2[i];
-        }
+        if (opt2bSet("-diff", NFILE, fnm))
+            forceMatrix = pairwise_forces.get_sparse_forcematrix_diff_of_frame(*ptr_pairwise_forces_diff, nbParticles, frame);
+        else
+            forceMatrix = pairwise_forces.get_sparse_forcematrix_of_frame(nbParticles, frame);
 
-        for (auto & f : forceMatrix) f = std::abs(f);
+        forceMatrix.abs();
 
         // Convert from kJ/mol/nm into pN
-        if (convert) for (auto & f : forceMatrix) f *= 1.66;
+        if (convert) forceMatrix *= 1.66;
 
         BoostGraph graph(forceMatrix);
         BoostGraph::PathList shortestPaths = graph.findKShortestPaths(source, dest, numberOfShortestPaths);
@@ -188,62 +196,58 @@ int gmx_fda_shortest_path(int argc, char *argv[])
         real time;
         rvec *coord_traj;
         matrix box;
+        read_first_x(oenv, &status, opt2fn("-f", NFILE, fnm), &time, &coord_traj, box);
+        int trajectoryFrame = 0;
+
+        // Each thread reads its frames with its own reader using the shared frame index
+        typedef fda::PairwiseForces<fda::Force<real>>::FrameReader FrameReader;
+        auto frameIndex = pairwise_forces.get_frame_index();
+        decltype(frameIndex) frameIndexDiff;
+        if (ptr_pairwise_forces_diff) frameIndexDiff = ptr_pairwise_forces_diff->get_frame_index();
+
+        std::vector<std::unique_ptr<FrameReader>> frameReaders(nbThreads), frameReadersDiff(nbThreads);
+        for (int thread = 0; thread != nbThreads; ++thread) {
+            frameReaders[thread].reset(new FrameReader(pairwise_forces));
+            if (ptr_pairwise_forces_diff) frameReadersDiff[thread].reset(new FrameReader(*ptr_pairwise_forces_diff));
+        }
 
-        for (int frame = 0; frame < nbFrames; ++frame)
+        // For "average n" each interval is processed from its first frame
+        NetworkFrames networkFrames(frameType, frameValue, convert);
+        std::vector<int> frames;
+        int frameStep = frameType == ALL ? 1 : frameValue;
+        if (frameStep < 1) gmx_fatal(FARGS, "Frame interval must be positive.");
+        for (int frame = 0; frame < nbFrames; frame += frameStep) frames.push_back(frame);
+
+        struct FrameResult
         {
-            if (frame == 0) read_first_x(oenv, &status, opt2fn("-f", NFILE, fnm), &time, &coord_traj, box);
-            else read_next_x(oenv, status, &time, coord_traj, box);
-
-            if (frameType == SKIP and frame%frameValue) continue;
-
-            forceMatrix = pairwise_forces.get_forcematrix_of_frame(nbParticles, frame);
-            if (opt2bSet("-diff", NFILE, fnm)) {
-                forceMatrix2 = ptr_pairwise_forces_diff->get_forcematrix_of_frame(nbParticles, frame);
-                for (int i = 0; i < nbParticles2; ++i) forceMatrix[i] -= forceMatrix2[i];
-            }
-            for (auto & f : forceMatrix) f = std::abs(f);
-
-            // Convert from kJ/mol/nm into pN
-            if (convert) for (auto & f : forceMatrix) f *= 1.66;
-
-            if (frameType == AVERAGE) {
-                for (int frameAvg = 0; frameAvg < frameValue - 1; ++frameAvg)
-                {
-                    std::vector<double> forceMatrixAvg, forceMatrixAvg2;
-                    forceMatrixAvg = pairwise_forces.get_forcematrix_of_frame(nbParticles, frame);
-                    if (opt2bSet("-diff", NFILE, fnm)) {
-                        forceMatrixAvg2 = ptr_pairwise_forces_diff->get_forcematrix_of_frame(nbParticles, frame);
-                        for (int i = 0; i < nbParticles2; ++i) forceMatrixAvg[i] -= forceMatrixAvg2[i];
-                    }
-
-                    for (auto & f : forceMatrixAvg) f = std::abs(f);
-
-                    // Convert from kJ/mol/nm into pN
-                    if (convert) for (auto & f : forceMatrixAvg) f *= 1.66;
-
-                    for (int i = 0; i < nbParticles2; ++i) forceMatrix[i] += forceMatrixAvg[i];
-                }
-                for (int i = 0; i < nbParticles2; ++i) forceMatrix[i] /= frameValue;
-            }
-
-            BoostGraph graph(forceMatrix);
-            BoostGraph::PathList shortestPaths = graph.findKShortestPaths(source, dest, numberOfShortestPaths);
-
-            pdb.updateCoordinates(coord_traj);
-            pdb.writePaths(opt2fn("-o", NFILE, fnm), shortestPaths, forceMatrix, frame);
-
-            // Write moleculare trajectory for pymol script
-            if (opt2bSet("-pymol", NFILE, fnm))
-                write_pdbfile(molecularTrajectoryFile, "FDA trajectory for Pymol visualization", &top.atoms, coord_traj, ePBC, box, ' ', 0, nullptr);
-
-            if (frameType == AVERAGE) {
-                frame += frameValue - 1;
-                // It would be better to skip the next frameValue - 1 frames instead of reading them.
-                for (int frameAvg = 0; frameAvg < frameValue - 1; ++frameAvg) {
-                    read_next_x(oenv, status, &time, coord_traj, box);
-                }
-            }
-        }
+            fda::SparseForceMatrix forceMatrix;
+            BoostGraph::PathList shortestPaths;
+        };
+
+        processFramesInParallel<FrameResult>(frames, nbThreads,
+            [&](int frame, FrameResult& result, int thread)
+            {
+                fda::SparseForceMatrix& forceMatrix = result.forceMatrix;
+                frameReaders[thread]->seek(frame, frameIndex);
+                if (frameReadersDiff[thread]) frameReadersDiff[thread]->seek(frame, frameIndexDiff);
+                if (!networkFrames.read(*frameReaders[thread], frameReadersDiff[thread].get(), nbParticles, forceMatrix))
+                    gmx_fatal(FARGS, "Frame not found.");
+
+                BoostGraph graph(forceMatrix);
+                result.shortestPaths = graph.findKShortestPaths(source, dest, numberOfShortestPaths);
+            },
+            [&](int frame, FrameResult const& result)
+            {
+                for (; trajectoryFrame < frame; ++trajectoryFrame) read_next_x(oenv, status, &time, coord_traj, box);
+
+                pdb.updateCoordinates(coord_traj);
+                pdb.writePaths(opt2fn("-o", NFILE, fnm), result.shortestPaths, result.forceMatrix, frame);
+
+                // Write moleculare trajectory for pymol script
+                if (opt2bSet("-pymol", NFILE, fnm))
+                    write_pdbfile(molecularTrajectoryFile, "FDA trajectory for Pymol visualization", &top.atoms, coord_traj, ePBC, box, ' ', 0, nullptr);
+            });
+
         close_trx(status);
     }
 
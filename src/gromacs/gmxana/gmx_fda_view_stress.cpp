@@ -8,7 +8,6 @@
 #include <cmath>
 #include <cstdio>
 #include <iostream>
-#include <limits>
 #include <string>
 #include <vector>
 #include "fda/EnumParser.h"
@@ -16,12 +15,12 @@
 #include "fda/Helpers.h"
 #include "fda/ParticleType.h"
 #include "fda/StressType.h"
+#include "fda/StressView.h"
 #include "gmx_ana.h"
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/fda/Stress.h"
 #include "gromacs/fileio/confio.h"
-#include "gromacs/fileio/matio.h"
 #include "gromacs/fileio/pdbio.h"
 #include "gromacs/fileio/tpxio.h"
 #include "gromacs/fileio/trxio.h"
@@ -34,7 +33,6 @@
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/real.h"
-#include "gromacs/utility/smalloc.h"
 
 #ifdef HAVE_CONFIG_H
   #include <config.h>
@@ -209,55 +207,7 @@ int gmx_fda_view_stress(int argc, char *argv[])
         }
     } else if (fn2ftp(opt2fn("-o", NFILE, fnm)) == efXPM) {
 
-        // Reorder stressMatrix for writing xpm
-        real **stressMatrix2 = nullptr;
-        snew(stressMatrix2, nbParticles);
-        real minValue = std::numeric_limits<real>::max();
-        real maxValue = 0;
-        int nbFramesForOutput = 1;
-        if (frameType == SINGLE) {
-            for (int i = 0; i < nbParticles; ++i) {
-                snew(stressMatrix2[i], nbFramesForOutput);
-                real value = stress[frameValue][i];
-                stressMatrix2[i][0] = value;
-                if (value < minValue) minValue = value;
-                if (value > maxValue) maxValue = value;
-            }
-        } else {
-            nbFramesForOutput = ceil(static_cast<real>(nbFrames) / frameValue);
-            for (int i = 0; i < nbParticles; ++i) {
-                snew(stressMatrix2[i], nbFramesForOutput);
-                if (frameType == AVERAGE) {
-                    for (int j = 0, js = 0; j < nbFramesForOutput; ++j) {
-                        real value = 0.0;
-                        for (int k = 0; k < frameValue and js < nbFrames; ++k, ++js) value += stress[js][i];
-                        value /= frameValue;
-                        stressMatrix2[i][j] = value;
-                        if (value < minValue) minValue = value;
-                        if (value > maxValue) maxValue = value;
-                    }
-                } else {
-                    for (int j = 0, js = 0; j < nbFramesForOutput; ++j, js += frameValue) {
-                        real value = stress[js][i];
-                        stressMatrix2[i][j] = value;
-                        if (value < minValue) minValue = value;
-                        if (value > maxValue) maxValue = value;
-                    }
-                }
-            }
-        }
-
-        FILE *out = gmx_ffopen(opt2fn("-o", NFILE, fnm), "w");
-        t_rgb rlo = {1, 1, 1}, rhi = {0, 0, 0};
-        real *t_x;
-        real *t_y;
-        snew(t_x, nbParticles);
-        snew(t_y, nbFramesForOutput);
-        for (int i = 0; i < nbParticles; ++i) t_x[i] = i;
-        for (int i = 0; i < nbFramesForOutput; ++i) t_y[i] = i;
-        write_xpm(out, 0, title.c_str(), "", "Particle", "Frame", nbParticles, nbFramesForOutput,
-            t_x, t_y, stressMatrix2, minValue, maxValue, rlo, rhi, &nbColors);
-        gmx_ffclose(out);
+        writeStressXPM(opt2fn("-o", NFILE, fnm), title, stress, frameType, frameValue, nbColors);
 
     } else gmx_fatal(FARGS, "Missing output filename -opdb or -oxpm.");
 
@@ -517,6 +517,7 @@ bonds(int             nbonds,
  *
  * As plain-C bonds(), but using SIMD to calculate many bonds at once.
  * This routines does not calculate energies and shift forces.
+ * The SIMD flavor is never used with FDA, which always needs energies.
  */
 template<BondedKernelFlavor flavor>
 std::enable_if_t<flavor == BondedKernelFlavor::ForcesSimdWhenAvailable, real>
@@ -531,7 +532,8 @@ bonds(int             nbonds,
       real gmx_unused* dvdlambda,
       const t_mdatoms gmx_unused* md,
       t_fcdata gmx_unused* fcd,
-      int gmx_unused* global_atom_index)
+      int gmx_unused* global_atom_index,
+      FDA gmx_unused* fda)
 {
     constexpr int                            nfa1 = 3;
     alignas(GMX_SIMD_ALIGNMENT) std::int32_t ai[GMX_SIMD_REAL_WIDTH];
@@ -1119,7 +1121,8 @@ angles(int             nbonds,
        real gmx_unused* dvdlambda,
        const t_mdatoms gmx_unused* md,
        t_fcdata gmx_unused* fcd,
-       int gmx_unused* global_atom_index)
+       int gmx_unused* global_atom_index,
+       FDA gmx_unused* fda)
 {
     const int                                nfa1 = 4;
     int                                      i, iu, s;
@@ -1479,7 +1482,8 @@ urey_bradley(int             nbonds,
              real gmx_unused* dvdlambda,
              const t_mdatoms gmx_unused* md,
              t_fcdata gmx_unused* fcd,
-             int gmx_unused* global_atom_index)
+             int gmx_unused* global_atom_index,
+             FDA gmx_unused* fda)
 {
     constexpr int                            nfa1 = 4;
     alignas(GMX_SIMD_ALIGNMENT) std::int32_t ai[GMX_SIMD_REAL_WIDTH];
@@ -2054,7 +2058,8 @@ pdihs(int             nbonds,
       real gmx_unused* dvdlambda,
       const t_mdatoms gmx_unused* md,
       t_fcdata gmx_unused* fcd,
-      int gmx_unused* global_atom_index)
+      int gmx_unused* global_atom_index,
+      FDA gmx_unused* fda)
 {
     const int                                nfa1 = 5;
     int                                      i, iu, s;
@@ -2168,7 +2173,8 @@ rbdihs(int             nbonds,
        real gmx_unused* dvdlambda,
        const t_mdatoms gmx_unused* md,
        t_fcdata gmx_unused* fcd,
-       int gmx_unused* global_atom_index)
+       int gmx_unused* global_atom_index,
+       FDA gmx_unused* fda)
 {
     const int                                nfa1 = 5;
     int                                      i, iu, s, j;
@@ -515,7 +515,10 @@ static real do_pairs_general(int                 ftype,
         rvec_inc(f[ai], dx);
         rvec_dec(f[aj], dx);
 
-       	fda->add_bonded(ai, aj, fda::InteractionType_NB14, dx);
+        if (fda)
+        {
+            fda->add_bonded(ai, aj, fda::InteractionType_NB14, dx);
+        }
 
         if (computeVirial(flavor))
         {
@@ -65,6 +65,7 @@
 #include "gromacs/essentialdynamics/edsam.h"
 #include "gromacs/ewald/pme_load_balancing.h"
 #include "gromacs/ewald/pme_pp.h"
+#include "gromacs/fda/FDA.h"
 #include "gromacs/fileio/trxio.h"
 #include "gromacs/gmxlib/network.h"
 #include "gromacs/gmxlib/nrnb.h"
@@ -355,6 +356,17 @@ void gmx::LegacySimulator::do_md()
         upd.setNumAtoms(state->natoms);
     }
 
+    // FDA is only switched on every nstfda steps, the topology is not filtered
+    // by the FDA bonded exclusions to keep the dynamics unchanged
+    FDA* const fda    = fr->fda;
+    const int  nstfda = fda ? fda->get_settings().nstfda : 0;
+    if (nstfda > 0 && (shellfc || fr->useMts || useGpuForNonbonded))
+    {
+        gmx_fatal(FARGS,
+                  "FDA in MD runs (nstfda > 0) is not supported with shells, multiple time "
+                  "stepping or GPU nonbonded kernels.\n");
+    }
+
     std::unique_ptr<UpdateConstrainGpu> integrator;
 
     StatePropagatorDataGpu* stateGpu = fr->stateGpu;
@@ -904,9 +916,13 @@ void gmx::LegacySimulator::do_md()
         bGStat = (bCalcVir || bCalcEner || bStopCM || do_per_step(step, nstglobalcomm)
                   || (EI_VV(ir->eI) && inputrecNvtTrotter(ir) && do_per_step(step - 1, nstglobalcomm)));
 
+        /* The FDA hooks are only called on FDA steps and only in the energy kernels */
+        const bool bFdaStep = nstfda > 0 && do_per_step(step, nstfda);
+        fr->fda             = bFdaStep ? fda : nullptr;
+
         force_flags = (GMX_FORCE_STATECHANGED | ((inputrecDynamicBox(ir)) ? GMX_FORCE_DYNAMICBOX : 0)
                        | GMX_FORCE_ALLFORCES | (bCalcVir ? GMX_FORCE_VIRIAL : 0)
-                       | (bCalcEner ? GMX_FORCE_ENERGY : 0) | (bDoFEP ? GMX_FORCE_DHDL : 0));
+                       | ((bCalcEner || bFdaStep) ? GMX_FORCE_ENERGY : 0) | (bDoFEP ? GMX_FORCE_DHDL : 0));
         if (fr->useMts && !do_per_step(step, ir->nstfout))
         {
             force_flags |= GMX_FORCE_DO_NOT_NEED_NORMAL_FORCE;
@@ -949,6 +965,18 @@ void gmx::LegacySimulator::do_md()
                      (bNS ? GMX_FORCE_NS : 0) | force_flags, ddBalanceRegionHandler);
         }
 
+        if (bFdaStep)
+        {
+            // FDA writes on the master rank, which needs the coordinates of all atoms
+            if (DOMAINDECOMP(cr))
+            {
+                dd_collect_vec(cr->dd, state->ddp_count, state->ddp_count_cg_gl, state->cg_gl,
+                               state->x, state_global->x);
+            }
+            fda->save_and_write_scalar_time_averages(DOMAINDECOMP(cr) ? state_global->x : state->x,
+                                                     state->box, top_global);
+        }
+
         // VV integrators do not need the following velocity half step
         // if it is the first step after starting from a checkpoint.
         // That is, the half step is needed on all other steps, and
@@ -1690,6 +1718,12 @@ void gmx::LegacySimulator::do_md()
      * before stopping the time measurements. */
     mdoutf_tng_close(outf);
 
+    fr->fda = fda;
+    if (nstfda > 0)
+    {
+        fda->write_scalar_time_averages();
+    }
+
     /* Stop measuring walltime */
     walltime_accounting_end_time(walltime_accounting);
 
@@ -325,14 +325,14 @@ void gmx::LegacySimulator::do_rerun()
     }
     else
     {
-        fda::FDASettings fda_settings = fr->fda->get_settings();
-        gmx_mtop_generate_local_top(*top_global, &top, ir->efep != efepNO, &fda_settings);
-
         state_change_natoms(state_global, state_global->natoms);
         /* Copy the pointer to the global state */
         state = state_global;
 
-        mdAlgorithmsSetupAtomData(cr, ir, *top_global, &top, fr, &f, mdAtoms, constr, vsite, shellfc);
+        // The local topology is generated here, filtered by the FDA bonded exclusions
+        fda::FDASettings fda_settings = fr->fda->get_settings();
+        mdAlgorithmsSetupAtomData(cr, ir, *top_global, &top, fr, &f, mdAtoms, constr, vsite,
+                                  shellfc, &fda_settings);
     }
 
     auto mdatoms = mdAtoms->mdatoms();
@@ -563,8 +563,14 @@ void gmx::LegacySimulator::do_rerun()
                      vsite, mu_tot, t, ed, GMX_FORCE_NS | force_flags, ddBalanceRegionHandler);
         }
 
-        // FDA
-        fr->fda->save_and_write_scalar_time_averages(state->x, state->box, top_global);
+        // FDA writes on the master rank, which needs the coordinates of all atoms
+        if (DOMAINDECOMP(cr))
+        {
+            dd_collect_vec(cr->dd, state->ddp_count, state->ddp_count_cg_gl, state->cg_gl, state->x,
+                           state_global->x);
+        }
+        fr->fda->save_and_write_scalar_time_averages(DOMAINDECOMP(cr) ? state_global->x : state->x,
+                                                     state->box, top_global);
 
         /* Now we have the energies and forces corresponding to the
          * coordinates at time t.
@@ -798,6 +798,15 @@ int Mdrunner::mdrunner()
                                    globalState.get(), inputrec.get(), &mtop);
     }
 
+#ifdef BUILD_WITH_FDA
+    // FDA accumulates the pairwise forces per OpenMP thread and gathers them over the ranks
+    // at each frame, so use one thread-MPI rank unless the user requested otherwise
+    if (GMX_THREAD_MPI && hw_opt.nthreads_tmpi < 1)
+    {
+        hw_opt.nthreads_tmpi = 1;
+    }
+#endif
+
     /* Check and update the hardware options for internal consistency */
     checkAndUpdateHardwareOptions(mdlog, &hw_opt, isSimulationMasterRank, domdecOptions.numPmeRanks,
                                   inputrec.get());
@@ -847,7 +856,7 @@ int Mdrunner::mdrunner()
     GMX_RELEASE_ASSERT(cr != nullptr, "Must have valid commrec");
 
 #ifdef BUILD_WITH_FDA
-    ptr_fda_settings = std::make_shared<fda::FDASettings>(filenames.size(), filenames.data(), &mtop, PAR(cr));
+    ptr_fda_settings = std::make_shared<fda::FDASettings>(filenames.size(), filenames.data(), &mtop, MASTER(cr));
     ptr_fda = std::make_shared<FDA>(*ptr_fda_settings);
 #endif
 
@@ -1498,6 +1507,31 @@ int Mdrunner::mdrunner()
 
 #ifdef BUILD_WITH_FDA
         fr->fda = ptr_fda.get();
+        fr->fda->init_threads(std::max(gmx_omp_nthreads_get(emntNonbonded), gmx_omp_nthreads_get(emntBonded)));
+        if (ptr_fda_settings->restrict_pairlist)
+        {
+            // Only the pairwise forces are of interest, the total forces will be incomplete
+            if (!doRerun || fr->nbv->useGpu())
+            {
+                gmx_fatal(FARGS, "FDA restrict_pairlist is only supported for reruns with CPU nonbonded kernels.\n");
+            }
+            fr->nbv->setPairlistGroupFilter(ptr_fda_settings->get_atom_group_bits());
+        }
+        if (DOMAINDECOMP(cr))
+        {
+            // The group filter of the pair search and the bonded exclusions of the topology
+            // are based on global atom indices
+            if (ptr_fda_settings->restrict_pairlist)
+            {
+                gmx_fatal(FARGS, "FDA restrict_pairlist is not supported with domain decomposition.\n");
+            }
+            if (doRerun && ptr_fda_settings->bonded_exclusion_on
+                && (ptr_fda_settings->type & (fda::InteractionType_BONDED + fda::InteractionType_NB14)))
+            {
+                gmx_fatal(FARGS, "FDA bonded_exclusion is not supported with domain decomposition, please set bonded_exclusion = no.\n");
+            }
+            fr->fda->init_domain_decomposition(cr);
+        }
 #endif
 
         /* Initialize the mdAtoms structure.
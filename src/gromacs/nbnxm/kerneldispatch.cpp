@@ -242,6 +242,14 @@ static void nbnxn_kernel_cpu(const PairlistSet&         pairlistSet,
 
     gmx::ArrayRef<const NbnxnPairlistCpu> pairlists = pairlistSet.cpuLists();
 
+    /* The kernels only compute pairwise forces with energies */
+    if (fda && stepWork.computeEnergy)
+    {
+        /* With domain decomposition FDA needs the global atom indices */
+        cellInv = fda->get_global_cell_indices(cellInv);
+        fda->update_cluster_group_bits(cellInv.data(), cellInv.ssize());
+    }
+
     int gmx_unused nthreads = gmx_omp_nthreads_get(emntNonbonded);
     wallcycle_sub_start(wcycle, ewcsNONBONDED_CLEAR);
 #pragma omp parallel for schedule(static) num_threads(nthreads)
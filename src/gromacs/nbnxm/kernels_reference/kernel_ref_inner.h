@@ -52,6 +52,17 @@
 
 #ifdef ENERGY_GROUPS
     egp_cj = nbatParams.energrp[cj];
+#endif
+#ifdef CALC_ENERGIES
+    /* Skip the pairwise forces of cluster pairs without a group1-group2 pair */
+    const bool fda_cj = fda_ci_bits != 0
+                        && fda::ClusterGroupBits::pair_in_groups(
+                                   fda_ci_bits, fda->get_cluster_group_bits().j_cluster(cj, UNROLLJ));
+    real fda_fcoul[UNROLLI * UNROLLJ];
+    real fda_flj[UNROLLI * UNROLLJ];
+    real fda_dx[UNROLLI * UNROLLJ];
+    real fda_dy[UNROLLI * UNROLLJ];
+    real fda_dz[UNROLLI * UNROLLJ];
 #endif
     for (i = 0; i < UNROLLI; i++)
     {
@@ -353,8 +364,8 @@
                 /* 2 flops for scalar LJ+Coulomb force */
 
 #ifdef CALC_ENERGIES
-                /* pairwise forces */
-                fda->add_nonbonded(cellInv[ai], cellInv[aj], fcoul, fvdw, dx, dy, dz);
+                fda_fcoul[i * UNROLLJ + j] = fcoul;
+                fda_flj[i * UNROLLJ + j]   = fvdw;
 #endif
             }
 #    ifdef HALF_LJ
@@ -363,8 +374,8 @@
                 fscal = fcoul;
 
 #ifdef CALC_ENERGIES
-				/* pairwise forces */
-                fda->add_nonbonded_single(cellInv[ai], cellInv[aj], fda::InteractionType_COULOMB, fcoul, dx, dy, dz);
+                fda_fcoul[i * UNROLLJ + j] = fcoul;
+                fda_flj[i * UNROLLJ + j]   = 0;
 #endif
             }
 #    endif
@@ -372,9 +383,15 @@
             fscal = frLJ * rinvsq;
 
 #ifdef CALC_ENERGIES
-            /* pairwise forces */
-            fda->add_nonbonded_single(cellInv[ai], cellInv[aj], fda::InteractionType_LJ, fscal, dx, dy, dz);
+            fda_fcoul[i * UNROLLJ + j] = 0;
+            fda_flj[i * UNROLLJ + j]   = fscal;
 #endif
+#endif
+#ifdef CALC_ENERGIES
+            /* pairwise forces */
+            fda_dx[i * UNROLLJ + j] = dx;
+            fda_dy[i * UNROLLJ + j] = dy;
+            fda_dz[i * UNROLLJ + j] = dz;
 #endif
             fx = fscal * dx;
             fy = fscal * dy;
@@ -391,6 +408,26 @@
             /* 9 flops for force addition */
         }
     }
+#ifdef CALC_ENERGIES
+    if (fda_cj)
+    {
+        /* All pairs of the cluster pair are recorded, as for the pairs beyond the cut-off the forces are zero */
+#    ifdef CALC_COULOMB
+#        ifdef HALF_LJ
+        const int fda_nlj = UNROLLI / 2;
+#        else
+        const int fda_nlj = UNROLLI;
+#        endif
+        const bool fda_coulomb = true;
+#    else
+        const int  fda_nlj     = UNROLLI;
+        const bool fda_coulomb = false;
+#    endif
+        fda_buffer->add_cluster_pair<UNROLLI, UNROLLJ>(cellInv + ci * UNROLLI, cellInv + cj * UNROLLJ,
+                                                       fda_nlj, fda_coulomb, nullptr, fda_fcoul,
+                                                       fda_flj, fda_dx, fda_dy, fda_dz);
+    }
+#endif
 }
 
 #undef interact
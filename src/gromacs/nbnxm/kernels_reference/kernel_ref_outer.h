@@ -128,6 +128,11 @@ void
 
     real xi[UNROLLI * XI_STRIDE];
     real fi[UNROLLI * FI_STRIDE];
+
+#ifdef CALC_ENERGIES
+    /* Pairwise forces are collected per cluster pair and added in one batch */
+    fda::NonbondedBuffer* fda_buffer = fda ? fda->get_thread_nonbonded_buffer() : nullptr;
+#endif
     real qi[UNROLLI];
 
 #ifdef CALC_ENERGIES
@@ -246,6 +251,10 @@ void
         /* Currently only works super-cells equal to sub-cells */
         ci    = ciEntry.ci;
         ci_sh = (ish == CENTRAL ? ci : -1);
+#ifdef CALC_ENERGIES
+        /* FDA group bits of the i-cluster, zero skips all pairwise force work */
+        const int fda_ci_bits = fda_buffer ? fda->get_cluster_group_bits().i_cluster(ci) : 0;
+#endif
 
         /* We have 5 LJ/C combinations, but use only three inner loops,
          * as the other combinations are unlikely and/or not much faster:
@@ -407,6 +416,13 @@ void
 #endif
     }
 
+#ifdef CALC_ENERGIES
+    if (fda_buffer)
+    {
+        fda->drain_nonbonded_buffer(*fda_buffer);
+    }
+#endif
+
 #ifdef COUNT_PAIRS
     printf("atom pairs %d\n", npair);
 #endif
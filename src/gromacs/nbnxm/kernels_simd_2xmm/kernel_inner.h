@@ -878,6 +878,56 @@
     fscal_S2 = rinvsq_S2 * frcoul_S2;
 #endif
 
+#ifdef CALC_ENERGIES
+    /* Store the scalar pair forces of this cluster pair in the FDA side buffer,
+     * the lanes of S0 hold i-atoms 0 and 1, those of S2 i-atoms 2 and 3.
+     * As in the reference kernel all pairs are recorded, beyond the cut-off the masked forces are zero.
+     */
+    if (fda_ci_bits != 0
+        && fda::ClusterGroupBits::pair_in_groups(fda_ci_bits,
+                                                 fda->get_cluster_group_bits().j_cluster(cj, UNROLLJ)))
+    {
+        alignas(GMX_SIMD_ALIGNMENT) real fda_fcoul[UNROLLI * UNROLLJ];
+        alignas(GMX_SIMD_ALIGNMENT) real fda_flj[UNROLLI * UNROLLJ];
+        alignas(GMX_SIMD_ALIGNMENT) real fda_dx[UNROLLI * UNROLLJ];
+        alignas(GMX_SIMD_ALIGNMENT) real fda_dy[UNROLLI * UNROLLJ];
+        alignas(GMX_SIMD_ALIGNMENT) real fda_dz[UNROLLI * UNROLLJ];
+
+#    ifdef CALC_COULOMB
+        store(fda_fcoul + 0 * UNROLLJ, rinvsq_S0 * frcoul_S0);
+        store(fda_fcoul + 2 * UNROLLJ, rinvsq_S2 * frcoul_S2);
+#    else
+        store(fda_fcoul + 0 * UNROLLJ, zero_S);
+        store(fda_fcoul + 2 * UNROLLJ, zero_S);
+#    endif
+        store(fda_flj + 0 * UNROLLJ, rinvsq_S0 * frLJ_S0);
+#    ifndef HALF_LJ
+        store(fda_flj + 2 * UNROLLJ, rinvsq_S2 * frLJ_S2);
+#    else
+        store(fda_flj + 2 * UNROLLJ, zero_S);
+#    endif
+        store(fda_dx + 0 * UNROLLJ, dx_S0);
+        store(fda_dx + 2 * UNROLLJ, dx_S2);
+        store(fda_dy + 0 * UNROLLJ, dy_S0);
+        store(fda_dy + 2 * UNROLLJ, dy_S2);
+        store(fda_dz + 0 * UNROLLJ, dz_S0);
+        store(fda_dz + 2 * UNROLLJ, dz_S2);
+
+        fda_buffer->add_cluster_pair<UNROLLI, UNROLLJ>(cellInv + ci * UNROLLI, cellInv + cj * UNROLLJ,
+#    ifdef HALF_LJ
+                                                       UNROLLI / 2,
+#    else
+                                                       UNROLLI,
+#    endif
+#    ifdef CALC_COULOMB
+                                                       true,
+#    else
+                                                       false,
+#    endif
+                                                       nullptr, fda_fcoul, fda_flj, fda_dx, fda_dy, fda_dz);
+    }
+#endif /* CALC_ENERGIES */
+
     /* Calculate temporary vectorial force */
     tx_S0 = fscal_S0 * dx_S0;
     tx_S2 = fscal_S2 * dx_S2;
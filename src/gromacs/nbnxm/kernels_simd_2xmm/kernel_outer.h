@@ -41,6 +41,10 @@
     /* Unpack pointers for output */
     real* f      = out->f.data();
     real* fshift = out->fshift.data();
+#ifdef CALC_ENERGIES
+    /* As in the reference kernel, pairwise forces are only extracted when energies are computed */
+    fda::NonbondedBuffer* fda_buffer = fda ? fda->get_thread_nonbonded_buffer() : nullptr;
+#endif
 #ifdef CALC_ENERGIES
 #    ifdef ENERGY_GROUPS
     real* Vvdw = out->VSvdw.data();
@@ -364,6 +368,11 @@
         ci     = ciEntry.ci;
         ci_sh  = (ish == CENTRAL ? ci : -1);
 
+#ifdef CALC_ENERGIES
+        /* Skip the FDA extraction for i-clusters without atoms in the FDA groups */
+        const int fda_ci_bits = fda_buffer ? fda->get_cluster_group_bits().i_cluster(ci) : 0;
+#endif
+
         shX_S = SimdReal(shiftvec[ish3]);
         shY_S = SimdReal(shiftvec[ish3 + 1]);
         shZ_S = SimdReal(shiftvec[ish3 + 2]);
@@ -641,6 +650,13 @@
         /* Outer loop uses 6 flops/iteration */
     }
 
+#ifdef CALC_ENERGIES
+    if (fda_buffer)
+    {
+        fda->drain_nonbonded_buffer(*fda_buffer);
+    }
+#endif
+
 #ifdef COUNT_PAIRS
     printf("atom pairs %d\n", npair);
 #endif
@@ -1165,6 +1165,68 @@
     fscal_S3 = rinvsq_S3 * frcoul_S3;
 #    endif
 
+#    ifdef CALC_ENERGIES
+    /* Store the scalar pair forces of this cluster pair in the FDA side buffer.
+     * As in the reference kernel all pairs are recorded, beyond the cut-off the masked forces are zero.
+     */
+    if (fda_ci_bits != 0
+        && fda::ClusterGroupBits::pair_in_groups(fda_ci_bits,
+                                                 fda->get_cluster_group_bits().j_cluster(cj, UNROLLJ)))
+    {
+        alignas(GMX_SIMD_ALIGNMENT) real fda_fcoul[UNROLLI * UNROLLJ];
+        alignas(GMX_SIMD_ALIGNMENT) real fda_flj[UNROLLI * UNROLLJ];
+        alignas(GMX_SIMD_ALIGNMENT) real fda_dx[UNROLLI * UNROLLJ];
+        alignas(GMX_SIMD_ALIGNMENT) real fda_dy[UNROLLI * UNROLLJ];
+        alignas(GMX_SIMD_ALIGNMENT) real fda_dz[UNROLLI * UNROLLJ];
+
+#        ifdef CALC_COULOMB
+        store(fda_fcoul + 0 * UNROLLJ, rinvsq_S0 * frcoul_S0);
+        store(fda_fcoul + 1 * UNROLLJ, rinvsq_S1 * frcoul_S1);
+        store(fda_fcoul + 2 * UNROLLJ, rinvsq_S2 * frcoul_S2);
+        store(fda_fcoul + 3 * UNROLLJ, rinvsq_S3 * frcoul_S3);
+#        else
+        store(fda_fcoul + 0 * UNROLLJ, zero_S);
+        store(fda_fcoul + 1 * UNROLLJ, zero_S);
+        store(fda_fcoul + 2 * UNROLLJ, zero_S);
+        store(fda_fcoul + 3 * UNROLLJ, zero_S);
+#        endif
+        store(fda_flj + 0 * UNROLLJ, rinvsq_S0 * frLJ_S0);
+        store(fda_flj + 1 * UNROLLJ, rinvsq_S1 * frLJ_S1);
+#        ifndef HALF_LJ
+        store(fda_flj + 2 * UNROLLJ, rinvsq_S2 * frLJ_S2);
+        store(fda_flj + 3 * UNROLLJ, rinvsq_S3 * frLJ_S3);
+#        else
+        store(fda_flj + 2 * UNROLLJ, zero_S);
+        store(fda_flj + 3 * UNROLLJ, zero_S);
+#        endif
+        store(fda_dx + 0 * UNROLLJ, dx_S0);
+        store(fda_dx + 1 * UNROLLJ, dx_S1);
+        store(fda_dx + 2 * UNROLLJ, dx_S2);
+        store(fda_dx + 3 * UNROLLJ, dx_S3);
+        store(fda_dy + 0 * UNROLLJ, dy_S0);
+        store(fda_dy + 1 * UNROLLJ, dy_S1);
+        store(fda_dy + 2 * UNROLLJ, dy_S2);
+        store(fda_dy + 3 * UNROLLJ, dy_S3);
+        store(fda_dz + 0 * UNROLLJ, dz_S0);
+        store(fda_dz + 1 * UNROLLJ, dz_S1);
+        store(fda_dz + 2 * UNROLLJ, dz_S2);
+        store(fda_dz + 3 * UNROLLJ, dz_S3);
+
+        fda_buffer->add_cluster_pair<UNROLLI, UNROLLJ>(cellInv + ci * UNROLLI, cellInv + cj * UNROLLJ,
+#        ifdef HALF_LJ
+                                                       UNROLLI / 2,
+#        else
+                                                       UNROLLI,
+#        endif
+#        ifdef CALC_COULOMB
+                                                       true,
+#        else
+                                                       false,
+#        endif
+                                                       nullptr, fda_fcoul, fda_flj, fda_dx, fda_dy, fda_dz);
+    }
+#    endif /* CALC_ENERGIES */
+
     /* Calculate temporary vectorial force */
     tx_S0 = fscal_S0 * dx_S0;
     tx_S1 = fscal_S1 * dx_S1;
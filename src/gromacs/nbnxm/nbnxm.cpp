@@ -48,6 +48,7 @@
 #include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/nbnxm/atomdata.h"
 #include "gromacs/timing/wallcycle.h"
+#include "gromacs/utility/gmxassert.h"
 
 #include "nbnxm_gpu.h"
 #include "pairlistsets.h"
@@ -119,6 +120,14 @@ void nonbonded_verlet_t::setLocalAtomOrder()
     pairSearch_->setLocalAtomOrder();
 }
 
+void nonbonded_verlet_t::setPairlistGroupFilter(std::vector<unsigned char> atomGroupBits)
+{
+    GMX_RELEASE_ASSERT(atomGroupBits.empty() || !useGpu(),
+                       "Restricting the pairlist to groups is only supported with CPU pairlists");
+
+    pairSearch_->setGroupFilter(std::move(atomGroupBits));
+}
+
 void nonbonded_verlet_t::setAtomProperties(gmx::ArrayRef<const int>  atomTypes,
                                            gmx::ArrayRef<const real> atomCharges,
                                            gmx::ArrayRef<const int>  atomInfo)
@@ -112,6 +112,7 @@
 #define GMX_NBNXM_NBNXM_H
 
 #include <memory>
+#include <vector>
 
 #include "gromacs/gpu_utils/devicebuffer_datatype.h"
 #include "gromacs/math/vectypes.h"
@@ -265,6 +266,12 @@ public:
                            int64_t                      step,
                            t_nrnb*                      nrnb);
 
+    /*! \brief Restricts the CPU pairlists to cluster pairs with an atom of group 1 and an atom of group 2
+     *
+     * \param[in] atomGroupBits  Per global atom bit 0 is set for group 1 and bit 1 for group 2, empty disables the filter
+     */
+    void setPairlistGroupFilter(std::vector<unsigned char> atomGroupBits);
+
     //! Updates all the atom properties in Nbnxm
     void setAtomProperties(gmx::ArrayRef<const int>  atomTypes,
                            gmx::ArrayRef<const real> atomCharges,
@@ -3071,6 +3071,66 @@ static void setBufferFlags(const NbnxnPairlistGpu gmx_unused& nbl,
     GMX_ASSERT(false, "This function should never be called");
 }
 
+/*! \brief Returns the combined group bits of the atoms in \p cluster
+ *
+ * Filler atoms have a negative index and do not contribute.
+ */
+static int clusterGroupBits(gmx::ArrayRef<const unsigned char> atomGroupBits,
+                            gmx::ArrayRef<const int>           atomIndices,
+                            const int                          cluster,
+                            const int                          clusterSize)
+{
+    int bits = 0;
+    for (int a = cluster * clusterSize; a < (cluster + 1) * clusterSize; a++)
+    {
+        const int atom = atomIndices[a];
+        if (atom >= 0)
+        {
+            bits |= atomGroupBits[atom];
+        }
+    }
+    return bits;
+}
+
+//! Returns whether a cluster pair can contain an atom pair with one atom in group 1 and one in group 2
+static inline bool clusterPairInGroups(const int iGroupBits, const int jGroupBits)
+{
+    return ((iGroupBits & 1) && (jGroupBits & 2)) || ((iGroupBits & 2) && (jGroupBits & 1));
+}
+
+/*! \brief Removes the j-clusters from index \p cjIndexStart on which have no pair between the groups with the i-cluster
+ *
+ * Must be called before the j-clusters are counted and the buffer flags are set.
+ */
+static void filterJClustersByGroup(NbnxnPairlistCpu*                  nbl,
+                                   const int                          cjIndexStart,
+                                   const int                          iGroupBits,
+                                   gmx::ArrayRef<const unsigned char> atomGroupBits,
+                                   gmx::ArrayRef<const int>           atomIndices)
+{
+    int numKept = cjIndexStart;
+    for (int cjIndex = cjIndexStart; cjIndex < gmx::ssize(nbl->cj); cjIndex++)
+    {
+        const int jGroupBits =
+                clusterGroupBits(atomGroupBits, atomIndices, nbl->cj[cjIndex].cj, nbl->na_cj);
+        if (clusterPairInGroups(iGroupBits, jGroupBits))
+        {
+            nbl->cj[numKept++] = nbl->cj[cjIndex];
+        }
+    }
+    nbl->cj.resize(numKept);
+    nbl->ci.back().cj_ind_end = numKept;
+}
+
+static void filterJClustersByGroup(NbnxnPairlistGpu gmx_unused* nbl,
+                                   int gmx_unused cjIndexStart,
+                                   int gmx_unused iGroupBits,
+                                   gmx::ArrayRef<const unsigned char> gmx_unused atomGroupBits,
+                                   gmx::ArrayRef<const int> gmx_unused atomIndices)
+{
+    GMX_ASSERT(false, "Restricting the pairlist to groups is only supported with CPU pairlists");
+}
+
 /* Generates the part of pair-list nbl assigned to our thread */
 template<typename T>
 static void nbnxn_make_pairlist_part(const Nbnxm::GridSet&   gridSet,
@@ -3079,6 +3139,7 @@ static void nbnxn_make_pairlist_part(const Nbnxm::GridSet&   gridSet,
                                      PairsearchWork*         work,
                                      const nbnxn_atomdata_t* nbat,
                                      const ListOfLists<int>& exclusions,
+                                     gmx::ArrayRef<const unsigned char> atomGroupBits,
                                      real                    rlist,
                                      const PairlistType      pairlistType,
                                      int                     ci_block,
@@ -3237,6 +3298,17 @@ static void nbnxn_make_pairlist_part(const Nbnxm::GridSet&   gridSet,
         {
             continue;
         }
+        /* With a group filter, skip i-clusters without group atoms */
+        int iGroupBits = 0;
+        if (!atomGroupBits.empty())
+        {
+            iGroupBits = clusterGroupBits(atomGroupBits, gridSet.atomIndices(), cell0_i + ci,
+                                          c_nbnxnCpuIClusterSize);
+            if (iGroupBits == 0)
+            {
+                continue;
+            }
+        }
         ncj_old_i = getNumSimpleJClustersInList(*nbl);
 
         d2cx = 0;
@@ -3528,6 +3600,12 @@ static void nbnxn_make_pairlist_part(const Nbnxm::GridSet&   gridSet,
                                                            excludeSubDiagonal, nbat, rlist2, rbb2,
                                                            kernelType, &numDistanceChecks);
 
+                                    if (!atomGroupBits.empty())
+                                    {
+                                        filterJClustersByGroup(nbl, ncj_old_j, iGroupBits,
+                                                               atomGroupBits, gridSet.atomIndices());
+                                    }
+
                                     if (bFBufferFlag)
                                     {
                                         setBufferFlags(*nbl, ncj_old_j, gridj_flag_shift, gridj_flag, th);
@@ -3922,6 +4000,7 @@ void PairlistSet::constructPairlists(const Nbnxm::GridSet&         gridSet,
                                      gmx::ArrayRef<PairsearchWork> searchWork,
                                      nbnxn_atomdata_t*             nbat,
                                      const ListOfLists<int>&       exclusions,
+                                     gmx::ArrayRef<const unsigned char> atomGroupBits,
                                      const int                     minimumIlistCountForGpuBalancing,
                                      t_nrnb*                       nrnb,
                                      SearchCycleCounting*          searchCycleCounting)
@@ -4036,17 +4115,17 @@ void PairlistSet::constructPairlists(const Nbnxm::GridSet&         gridSet,
                     /* Divide the i cells equally over the pairlists */
                     if (isCpuType_)
                     {
-                        nbnxn_make_pairlist_part(gridSet, iGrid, jGrid, &work, nbat, exclusions, rlist,
-                                                 params_.pairlistType, ci_block, nbat->bUseBufferFlags,
-                                                 nsubpair_target, progBal, nsubpair_tot_est, th,
-                                                 numLists, &cpuLists_[th], fepListPtr);
+                        nbnxn_make_pairlist_part(gridSet, iGrid, jGrid, &work, nbat, exclusions,
+                                                 atomGroupBits, rlist, params_.pairlistType, ci_block,
+                                                 nbat->bUseBufferFlags, nsubpair_target, progBal,
+                                                 nsubpair_tot_est, th, numLists, &cpuLists_[th], fepListPtr);
                     }
                     else
                     {
-                        nbnxn_make_pairlist_part(gridSet, iGrid, jGrid, &work, nbat, exclusions, rlist,
-                                                 params_.pairlistType, ci_block, nbat->bUseBufferFlags,
-                                                 nsubpair_target, progBal, nsubpair_tot_est, th,
-                                                 numLists, &gpuLists_[th], fepListPtr);
+                        nbnxn_make_pairlist_part(gridSet, iGrid, jGrid, &work, nbat, exclusions,
+                                                 atomGroupBits, rlist, params_.pairlistType, ci_block,
+                                                 nbat->bUseBufferFlags, nsubpair_target, progBal,
+                                                 nsubpair_tot_est, th, numLists, &gpuLists_[th], fepListPtr);
                     }
 
                     work.cycleCounter.stop();
@@ -4218,6 +4297,7 @@ void PairlistSets::construct(const InteractionLocality iLocality,
             "local i-atoms");
 
     pairlistSet(iLocality).constructPairlists(gridSet, pairSearch->work(), nbat, exclusions,
+                                              pairSearch->atomGroupBits(),
                                               minimumIlistCountForGpuBalancing_, nrnb,
                                               &pairSearch->cycleCounting_);
 
@@ -52,6 +52,7 @@
 #define GMX_NBNXM_PAIRSEARCH_H
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "gromacs/domdec/domdec.h"
@@ -232,11 +233,28 @@ public:
     //! Returns the list of thread-local work objects
     gmx::ArrayRef<PairsearchWork> work() { return work_; }
 
+    /*! \brief Restricts the pair search to cluster pairs with an atom of group 1 and an atom of group 2
+     *
+     * Used for FDA reruns where only the pairwise forces between two groups are of interest.
+     * Only applied to CPU pairlists.
+     *
+     * \param[in] atomGroupBits  Per global atom bit 0 is set for group 1 and bit 1 for group 2, empty disables the filter
+     */
+    void setGroupFilter(std::vector<unsigned char> atomGroupBits)
+    {
+        atomGroupBits_ = std::move(atomGroupBits);
+    }
+
+    //! Returns the per atom group bits of the filter, empty when the pair search is not restricted
+    gmx::ArrayRef<const unsigned char> atomGroupBits() const { return atomGroupBits_; }
+
 private:
     //! The set of search grids
     Nbnxm::GridSet gridSet_;
     //! Work objects, one entry for each thread
     std::vector<PairsearchWork> work_;
+    //! Group bits per global atom for restricting the pair search, empty when not restricted
+    std::vector<unsigned char> atomGroupBits_;
 
 public:
     //! Cycle counting for measuring components of the search
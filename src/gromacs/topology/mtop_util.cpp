@@ -44,6 +44,8 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <vector>
+
 #include "gromacs/math/vectypes.h"
 #include "gromacs/topology/atoms.h"
 #include "gromacs/topology/block.h"
@@ -552,79 +554,98 @@ static void ilistcat(int ftype, t_ilist* dest, const InteractionList& src, int c
     }
 }
 
-static void pf_ilistcat(int                     ftype,
-		                InteractionList        *dest,
-						const InteractionList  &src,
-						int                     copies,
-                        int                     dnum,
-						int                     snum,
-						fda::FDASettings const &fda_settings)
+/*! \brief Returns a bitmap over all atoms of the system with the atoms of FDA group1 and group2 set
+ *
+ * The bitmap is built once per topology, so that bonded interactions can be
+ * filtered with a lookup instead of scanning the groups for every atom.
+ */
+static std::vector<char> pf_atom_in_groups(int natoms, const fda::FDASettings& fda_settings)
 {
-	// Return if no bonded interaction is needed.
-	if (!(fda_settings.type & (fda::InteractionType_BONDED + fda::InteractionType_NB14))) return;
-
-    int nral, c, i, a, atomIdx;
-    char needed;
+    std::vector<char> atomInGroups(natoms, 0);
+    for (int group : { fda_settings.index_group1, fda_settings.index_group2 })
+    {
+        for (int k = fda_settings.groups->index[group]; k < fda_settings.groups->index[group + 1]; k++)
+        {
+            atomInGroups[fda_settings.groups->a[k]] = 1;
+        }
+    }
+    return atomInGroups;
+}
 
-    nral = NRAL(ftype);
+//! Returns true if any atom of the interaction starting at iatoms is in the FDA groups
+static inline bool pf_interaction_needed(const int* iatoms, int nral, int dnum, const std::vector<char>& atomInGroups)
+{
+    for (int a = 0; a < nral; a++)
+    {
+        if (atomInGroups[dnum + iatoms[a + 1]])
+        {
+            return true;
+        }
+    }
+    return false;
+}
 
-    t_iatom *tmp;
-    snew(tmp, copies*src.size());
+//! Returns the number of entries of the bonded interactions needed by FDA of all copies
+static int pf_count_needed(int nral, const InteractionList& src, int copies, int dnum, int snum, const std::vector<char>& atomInGroups)
+{
     int len = 0;
-
-    int *g1atomsBeg = fda_settings.groups->a + fda_settings.groups->index[fda_settings.index_group1];
-    int *g1atomsEnd = fda_settings.groups->a + fda_settings.groups->index[fda_settings.index_group1 + 1];
-    int *g1atomsCur = nullptr;
-    int *g2atomsBeg = fda_settings.groups->a + fda_settings.groups->index[fda_settings.index_group2];
-    int *g2atomsEnd = fda_settings.groups->a + fda_settings.groups->index[fda_settings.index_group2 + 1];
-    int *g2atomsCur = nullptr;
-
-    for (c = 0; c < copies; c++)
+    for (int c = 0; c < copies; c++)
     {
-        for (i = 0; i < src.size(); )
+        for (int i = 0; i < src.size(); i += nral + 1)
         {
-            needed = 0;
-            for (a = 0; a < nral; a++)
+            if (pf_interaction_needed(src.iatoms.data() + i, nral, dnum + c * snum, atomInGroups))
             {
-            	atomIdx = dnum + src.iatoms[i+a+1];
-        		for (g1atomsCur = g1atomsBeg; g1atomsCur < g1atomsEnd; ++g1atomsCur) {
-        			if (atomIdx == *g1atomsCur) needed = 1;
-        		}
-        		for (g2atomsCur = g2atomsBeg; g2atomsCur < g2atomsEnd; ++g2atomsCur) {
-        			if (atomIdx == *g2atomsCur) needed = 1;
-        		}
+                len += nral + 1;
             }
-            if (needed) {
-                tmp[len++] = src.iatoms[i];
-                for (a = 0; a < nral; a++) tmp[len++] = dnum + src.iatoms[i+a+1];
-
-                #ifdef FDA_BONDEXCL_PRINT_DEBUG_ON
-					fprintf(stderr, "=== DEBUG === bonded interaction %i", ftype);
-					fprintf(stderr, " %i", src->iatoms[i]);
-					for (a = 0; a < nral; a++) fprintf(stderr, " %i", dnum + src->iatoms[i + a + 1]);
-					fprintf(stderr, " needed\n");
-					fflush(stderr);
-                #endif
-            } else {
-                #ifdef FDA_BONDEXCL_PRINT_DEBUG_ON
-					fprintf(stderr, "=== DEBUG === bonded interaction %i", ftype);
-					fprintf(stderr, " %i", src->iatoms[i]);
-					for (a = 0; a < nral; a++) fprintf(stderr, " %i", dnum + src->iatoms[i + a + 1]);
-					fprintf(stderr, " not needed\n");
-					fflush(stderr);
-                #endif
+        }
+    }
+    return len;
+}
+
+//! Writes the bonded interactions needed by FDA of all copies into dest
+static void pf_copy_needed(int                      nral,
+                           int*                     dest,
+                           const InteractionList&   src,
+                           int                      copies,
+                           int                      dnum,
+                           int                      snum,
+                           const std::vector<char>& atomInGroups)
+{
+    for (int c = 0; c < copies; c++)
+    {
+        int copyDnum = dnum + c * snum;
+        for (int i = 0; i < src.size(); i += nral + 1)
+        {
+            if (pf_interaction_needed(src.iatoms.data() + i, nral, copyDnum, atomInGroups))
+            {
+                *dest++ = src.iatoms[i];
+                for (int a = 0; a < nral; a++)
+                {
+                    *dest++ = copyDnum + src.iatoms[i + a + 1];
+                }
             }
-            i += a + 1;
         }
-        dnum += snum;
     }
+}
 
-    size_t destIndex = dest->iatoms.size();
-    dest->iatoms.resize(dest->iatoms.size() + len);
+static void pf_ilistcat(int                     ftype,
+		                InteractionList        *dest,
+						const InteractionList  &src,
+						int                     copies,
+                        int                     dnum,
+						int                     snum,
+						fda::FDASettings const &fda_settings,
+						const std::vector<char> &atomInGroups)
+{
+	// Return if no bonded interaction is needed.
+	if (!(fda_settings.type & (fda::InteractionType_BONDED + fda::InteractionType_NB14))) return;
 
-    for (i = 0; i < len; i++) dest->iatoms[destIndex++] = tmp[i];
+    int nral = NRAL(ftype);
+    int len = pf_count_needed(nral, src, copies, dnum, snum, atomInGroups);
 
-    sfree(tmp);
+    size_t destIndex = dest->iatoms.size();
+    dest->iatoms.resize(dest->iatoms.size() + len);
+    pf_copy_needed(nral, dest->iatoms.data() + destIndex, src, copies, dnum, snum, atomInGroups);
 }
 
 static void pf_ilistcat(int                     ftype,
@@ -633,73 +654,19 @@ static void pf_ilistcat(int                     ftype,
 						int                     copies,
                         int                     dnum,
 						int                     snum,
-						fda::FDASettings const &fda_settings)
+						fda::FDASettings const &fda_settings,
+						const std::vector<char> &atomInGroups)
 {
 	// Return if no bonded interaction is needed.
 	if (!(fda_settings.type & (fda::InteractionType_BONDED + fda::InteractionType_NB14))) return;
 
-    int nral, c, i, a, atomIdx;
-    char needed;
-
-    nral = NRAL(ftype);
-
-    t_iatom *tmp;
-    snew(tmp, copies*src.size());
-    int len = 0;
-
-    int *g1atomsBeg = fda_settings.groups->a + fda_settings.groups->index[fda_settings.index_group1];
-    int *g1atomsEnd = fda_settings.groups->a + fda_settings.groups->index[fda_settings.index_group1 + 1];
-    int *g1atomsCur = nullptr;
-    int *g2atomsBeg = fda_settings.groups->a + fda_settings.groups->index[fda_settings.index_group2];
-    int *g2atomsEnd = fda_settings.groups->a + fda_settings.groups->index[fda_settings.index_group2 + 1];
-    int *g2atomsCur = nullptr;
-
-    for (c = 0; c < copies; c++)
-    {
-        for (i = 0; i < src.size(); )
-        {
-            needed = 0;
-            for (a = 0; a < nral; a++)
-            {
-            	atomIdx = dnum + src.iatoms[i+a+1];
-        		for (g1atomsCur = g1atomsBeg; g1atomsCur < g1atomsEnd; ++g1atomsCur) {
-        			if (atomIdx == *g1atomsCur) needed = 1;
-        		}
-        		for (g2atomsCur = g2atomsBeg; g2atomsCur < g2atomsEnd; ++g2atomsCur) {
-        			if (atomIdx == *g2atomsCur) needed = 1;
-        		}
-            }
-            if (needed) {
-                tmp[len++] = src.iatoms[i];
-                for (a = 0; a < nral; a++) tmp[len++] = dnum + src.iatoms[i+a+1];
-
-                #ifdef FDA_BONDEXCL_PRINT_DEBUG_ON
-					fprintf(stderr, "=== DEBUG === bonded interaction %i", ftype);
-					fprintf(stderr, " %i", src->iatoms[i]);
-					for (a = 0; a < nral; a++) fprintf(stderr, " %i", dnum + src->iatoms[i + a + 1]);
-					fprintf(stderr, " needed\n");
-					fflush(stderr);
-                #endif
-            } else {
-                #ifdef FDA_BONDEXCL_PRINT_DEBUG_ON
-					fprintf(stderr, "=== DEBUG === bonded interaction %i", ftype);
-					fprintf(stderr, " %i", src->iatoms[i]);
-					for (a = 0; a < nral; a++) fprintf(stderr, " %i", dnum + src->iatoms[i + a + 1]);
-					fprintf(stderr, " not needed\n");
-					fflush(stderr);
-                #endif
-            }
-            i += a + 1;
-        }
-        dnum += snum;
-    }
+    int nral = NRAL(ftype);
+    int len = pf_count_needed(nral, src, copies, dnum, snum, atomInGroups);
 
     dest->nalloc = dest->nr + len;
     srenew(dest->iatoms, dest->nalloc);
-
-    for (i = 0; i < len; i++) dest->iatoms[dest->nr++] = tmp[i];
-
-    sfree(tmp);
+    pf_copy_needed(nral, dest->iatoms + dest->nr, src, copies, dnum, snum, atomInGroups);
+    dest->nr += len;
 }
 
 static const t_iparams& getIparams(const InteractionDefinitions& idef, const int index)
@@ -846,6 +813,13 @@ static void copyFFParametersFromMtop(const gmx_mtop_t& mtop, t_idef* idef)
 template<typename IdefType>
 static void copyIListsFromMtop(const gmx_mtop_t& mtop, IdefType* idef, bool mergeConstr, fda::FDASettings* ptr_fda_settings)
 {
+    bool fdaBondedExclusion = ptr_fda_settings and ptr_fda_settings->bonded_exclusion_on;
+    std::vector<char> fdaAtomInGroups;
+    if (fdaBondedExclusion)
+    {
+        fdaAtomInGroups = pf_atom_in_groups(mtop.natoms, *ptr_fda_settings);
+    }
+
     int natoms = 0;
     for (const gmx_molblock_t& molb : mtop.molblock)
     {
@@ -873,9 +847,9 @@ static void copyIListsFromMtop(const gmx_mtop_t& mtop, IdefType* idef, bool merg
             }
             else if (!(mergeConstr && ftype == F_CONSTRNC))
             {
-            	if (ptr_fda_settings and ptr_fda_settings->bonded_exclusion_on)
+            	if (fdaBondedExclusion)
                     pf_ilistcat(ftype, &idef->il[ftype], molt.ilist[ftype],
-                             molb.nmol, destnr, srcnr, *ptr_fda_settings);
+                             molb.nmol, destnr, srcnr, *ptr_fda_settings, fdaAtomInGroups);
             	else
                     ilistcat(ftype, &idef->il[ftype], molt.ilist[ftype],
                              molb.nmol, destnr, srcnr);
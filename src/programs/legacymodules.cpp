@@ -339,6 +339,8 @@ void registerLegacyModules(gmx::CommandLineModuleManager* manager)
                    "Generate the k-shortest paths of a FDA force network as pdb-graph");
     registerModule(manager, &gmx_fda_convert, "fda_convert",
                    "Convert FDA files");
+    registerModule(manager, &gmx_fda_pipeline, "fda_pipeline",
+                   "Run several FDA analyses in a single pass over the pairwise forces");
 
     {
         gmx::CommandLineModuleGroup group =
@@ -13,12 +13,15 @@
 #include "gromacs/simd/support.h"
 #include "gromacs/fda/PairwiseForces.h"
 #include "gromacs/options/filenameoption.h"
+#include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/path.h"
 #include "gromacs/utility/real.h"
 #include "gromacs/gmxpreprocess/grompp.h"
+#include "gromacs/nbnxm/nbnxm_simd.h"
 #include "programs/mdrun/mdrun_main.h"
 #include "testutils/cmdlinetest.h"
+#include "testutils/setenv.h"
 #include "testutils/testfilemanager.h"
 #include "testutils/TextSplitter.h"
 #include "testutils/LogicallyErrorComparer.h"
@@ -39,7 +42,8 @@ struct TestDataStructure
         std::string const& residueFileExtension,
         std::string const& trajectoryFilename = "traj.trr",
         bool is_vector = false,
-        bool must_die = false
+        bool must_die = false,
+        int nbThreads = 1
     )
       : trajectoryDirectory(trajectoryDirectory),
         testDirectory(testDirectory),
@@ -47,7 +51,8 @@ struct TestDataStructure
         residueFileExtension(residueFileExtension),
         trajectoryFilename(trajectoryFilename),
         is_vector(is_vector),
-        must_die(must_die)
+        must_die(must_die),
+        nbThreads(nbThreads)
     {}
 
     std::string trajectoryDirectory;
@@ -57,6 +62,7 @@ struct TestDataStructure
     std::string trajectoryFilename;
     bool is_vector;
     bool must_die;
+    int nbThreads;
 };
 
 //! Test fixture for FDA
@@ -96,7 +102,7 @@ TEST_P(FDATest, Basic)
     callRerun.addOption("-deffnm", "rerun");
     callRerun.addOption("-s", "topol.tpr");
     callRerun.addOption("-rerun", GetParam().trajectoryFilename);
-    callRerun.addOption("-nt", "1");
+    callRerun.addOption("-nt", GetParam().nbThreads);
     callRerun.addOption("-pfn", "index.ndx");
     callRerun.addOption("-pfi", "fda.pfi");
     if (!GetParam().atomFileExtension.empty()) callRerun.addOption(atomOption.c_str(), atomFilename.c_str());
@@ -142,6 +148,160 @@ TEST_P(FDATest, Basic)
     }
 }
 
+//! Test fixture for FDA in a regular MD run
+class FDAMDTest : public CommandLineTestBase
+{};
+
+//! An MD run with nstfda writes every nstfda steps the same forces as a rerun of these steps
+TEST_F(FDAMDTest, NstFda)
+{
+    std::string cwd = gmx::Path::getWorkingDirectory();
+    std::string dataPath = std::string(fileManager().getInputDataDirectory()) + "/data";
+    std::string testPath = fileManager().getTemporaryFilePath("/alagly_md_nstfda");
+
+    std::string cmd = "mkdir -p " + testPath;
+    ASSERT_FALSE(system(cmd.c_str()));
+
+    cmd = "cp -r " + dataPath + "/alagly_md_nstfda/* " + testPath;
+    ASSERT_FALSE(system(cmd.c_str()));
+
+    cmd = "cp -r " + dataPath + "/alagly_verlet/* " + testPath;
+    ASSERT_FALSE(system(cmd.c_str()));
+
+    gmx_chdir(testPath.c_str());
+
+    // topol.tpr has 10 steps and writes the coordinates of each step
+    ::gmx::test::CommandLine callMD;
+    callMD.append("gmx_fda mdrun");
+    callMD.addOption("-deffnm", "md");
+    callMD.addOption("-s", "topol.tpr");
+    callMD.addOption("-nt", 1);
+    callMD.addOption("-pfn", "index.ndx");
+    callMD.addOption("-pfi", "fda.pfi");
+    callMD.addOption("-pfa", "md.pfa");
+    callMD.addOption("-pfr", "md.pfr");
+
+    std::cout << "command: " << callMD.toString() << std::endl;
+    ASSERT_FALSE(gmx_mdrun(callMD.argc(), callMD.argv()));
+
+    ::gmx::test::CommandLine callRerun;
+    callRerun.append("gmx_fda mdrun");
+    callRerun.addOption("-deffnm", "rerun");
+    callRerun.addOption("-s", "topol.tpr");
+    callRerun.addOption("-rerun", "md.trr");
+    callRerun.addOption("-nt", 1);
+    callRerun.addOption("-pfn", "index.ndx");
+    callRerun.addOption("-pfi", "fda.pfi");
+    callRerun.addOption("-pfa", "rerun.pfa");
+    callRerun.addOption("-pfr", "rerun.pfr");
+
+    std::cout << "command: " << callRerun.toString() << std::endl;
+    ASSERT_FALSE(gmx_mdrun(callRerun.argc(), callRerun.argv()));
+
+    LogicallyEqualComparer<true, false> comparer(1e4);
+
+    for (std::string extension : {"pfa", "pfr"})
+    {
+        auto md = fda::PairwiseForces<fda::Force<real>>("md." + extension).get_all_pairwise_forces();
+        auto rerun = fda::PairwiseForces<fda::Force<real>>("rerun." + extension).get_all_pairwise_forces();
+
+        // Steps 0, 5 and 10
+        EXPECT_EQ(3U, md.size());
+        EXPECT_EQ(11U, rerun.size());
+
+        // Both runs build the pair list of the first step from the same coordinates
+        ASSERT_FALSE(md.empty() or rerun.empty());
+        ASSERT_EQ(rerun[0].size(), md[0].size());
+        for (size_t p = 0; p != md[0].size(); ++p) {
+            EXPECT_TRUE(md[0][p].equal(rerun[0][p], comparer))
+                << extension << ": " << md[0][p].i << " " << md[0][p].j << " "
+                << md[0][p].force << " != " << rerun[0][p].force;
+        }
+    }
+    gmx_chdir(cwd.c_str());
+}
+
+//! Test fixture for the SIMD nonbonded kernels, the parameter is the environment variable selecting the kernel
+class FDASimdKernelTest : public ::testing::WithParamInterface<const char*>,
+                          public CommandLineTestBase
+{};
+
+//! Returns true if the SIMD kernel selected by the environment variable is compiled
+bool haveSimdKernel(std::string const gmx_unused& name)
+{
+#ifdef GMX_NBNXN_SIMD_4XN
+    if (name == "GMX_NBNXN_SIMD_4XN") return true;
+#endif
+#ifdef GMX_NBNXN_SIMD_2XNN
+    if (name == "GMX_NBNXN_SIMD_2XNN") return true;
+#endif
+    return false;
+}
+
+//! The SIMD kernels give the same nonbonded pairwise forces as the plain-C kernel of the references
+TEST_P(FDASimdKernelTest, Nonbonded)
+{
+    if (!haveSimdKernel(GetParam())) {
+        std::cout << "Skipped, " << GetParam() << " kernel is not compiled" << std::endl;
+        return;
+    }
+
+    // Bonded forces are left out, their vector components differ between SIMD and non-SIMD builds
+    for (bool is_vector : {false, true})
+    {
+        std::string testDirectory = is_vector ? "alagly_pairwise_forces_vector_detailed_nonbonded"
+                                              : "alagly_pairwise_forces_scalar_detailed_nonbonded";
+
+        std::string cwd = gmx::Path::getWorkingDirectory();
+        std::string dataPath = std::string(fileManager().getInputDataDirectory()) + "/data";
+        std::string testPath = fileManager().getTemporaryFilePath("/" + testDirectory);
+
+        std::string cmd = "mkdir -p " + testPath;
+        ASSERT_FALSE(system(cmd.c_str()));
+
+        cmd = "cp -r " + dataPath + "/" + testDirectory + "/* " + testPath;
+        ASSERT_FALSE(system(cmd.c_str()));
+
+        cmd = "cp -r " + dataPath + "/alagly_verlet/* " + testPath;
+        ASSERT_FALSE(system(cmd.c_str()));
+
+        gmx_chdir(testPath.c_str());
+
+        ::gmx::test::CommandLine callRerun;
+        callRerun.append("gmx_fda mdrun");
+        callRerun.addOption("-deffnm", "rerun");
+        callRerun.addOption("-s", "topol.tpr");
+        callRerun.addOption("-rerun", "traj.trr");
+        callRerun.addOption("-nt", 1);
+        callRerun.addOption("-pfn", "index.ndx");
+        callRerun.addOption("-pfi", "fda.pfi");
+        callRerun.addOption("-pfa", "fda.pfa");
+        callRerun.addOption("-pfr", "fda.pfr");
+
+        std::cout << "command: " << GetParam() << " " << callRerun.toString() << std::endl;
+
+        gmxSetenv(GetParam(), "1", 1);
+        int result = gmx_mdrun(callRerun.argc(), callRerun.argv());
+        gmxUnsetenv(GetParam());
+        ASSERT_FALSE(result);
+
+        LogicallyEqualComparer<true, false> comparer(1e4);
+
+        for (std::string filename : {"fda.pfa", "fda.pfr"}) {
+            if (is_vector)
+                EXPECT_TRUE((fda::PairwiseForces<fda::Force<fda::Vector>>(filename).equal(
+                    fda::PairwiseForces<fda::Force<fda::Vector>>(filename + ".ref"), comparer))) << testDirectory << " " << filename;
+            else
+                EXPECT_TRUE((fda::PairwiseForces<fda::Force<real>>(filename).equal(
+                    fda::PairwiseForces<fda::Force<real>>(filename + ".ref"), comparer))) << testDirectory << " " << filename;
+        }
+        gmx_chdir(cwd.c_str());
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(AllFDASimdKernelTests, FDASimdKernelTest,
+                        ::testing::Values("GMX_NBNXN_SIMD_4XN", "GMX_NBNXN_SIMD_2XNN"));
+
 std::vector<TestDataStructure> get_tests()
 {
     std::vector<TestDataStructure> tests;
@@ -150,16 +310,22 @@ std::vector<TestDataStructure> get_tests()
     tests.push_back({"alagly_verlet", "alagly_pairwise_forces_scalar_summed_renumbered", "pfa", "pfr"});
     tests.push_back({"alagly_verlet", "alagly_pairwise_forces_scalar_summed_atom_based", "pfa", ""});
     tests.push_back({"alagly_verlet", "alagly_pairwise_forces_scalar_summed_no_residue_based", "pfa", ""});
+    tests.push_back({"alagly_verlet", "alagly_pairwise_forces_scalar_summed_restrict_pairlist", "pfa", "pfr"});
     tests.push_back({"alagly_verlet", "alagly_pairwise_forces_scalar_threshold", "pfa", "pfr"});
     tests.push_back({"alagly_verlet", "alagly_pairwise_forces_scalar_average_0", "pfa", "pfr"});
     tests.push_back({"alagly_verlet", "alagly_pairwise_forces_scalar_average_3", "pfa", "pfr"});
     tests.push_back({"alagly_verlet", "alagly_pairwise_forces_scalar_average_0_threshold", "pfa", "pfr"});
     tests.push_back({"alagly_verlet", "alagly_pairwise_forces_scalar_detailed", "pfa", "pfr"});
     tests.push_back({"alagly_verlet", "alagly_pairwise_forces_vector", "pfa", "pfr", "traj.trr", true});
+    tests.push_back({"alagly_verlet", "alagly_pairwise_forces_vector_async", "pfa", "pfr", "traj.trr", true});
     tests.push_back({"alagly_verlet", "alagly_pairwise_forces_scalar_detailed_nonbonded", "pfa", "pfr"});
     tests.push_back({"alagly_verlet", "alagly_pairwise_forces_vector_detailed_nonbonded", "pfa", "pfr", "traj.trr", true});
     tests.push_back({"alagly_verlet", "alagly_pairwise_forces_scalar_all", "pfa", "pfr"});
 
+    // The order of the pairs does not depend on the number of threads
+    tests.push_back({"alagly_verlet", "alagly_pairwise_forces_vector", "pfa", "pfr", "traj.trr", true, false, 4});
+    tests.push_back({"alagly_verlet", "alagly_pairwise_forces_scalar_detailed", "pfa", "pfr", "traj.trr", false, false, 4});
+
     tests.push_back({"alagly_verlet", "alagly_punctual_stress", "psa", "psr"});
     tests.push_back({"alagly_verlet", "alagly_punctual_stress_binary", "", ""});
     tests.push_back({"alagly_verlet", "alagly_punctual_stress_normalized", "psa", "psr"});